@@ -0,0 +1,248 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <string>
+#include "lib/interpreter.hpp"
+#include "lib/batch_executor.hpp"
+#include "lib/null_render.hpp"
+
+// A random program built from three-opcode units: register arithmetic, conditional jumps,
+// Cxkk, draws and screen clears, timers, keys and key waits, register stores, calls and Bnnn
+// jumps. Jumps land on unit starts, calls go to one subroutine after the last unit that ends in
+// 00EE, and every Fx55/Fx65 is followed by an Annn, so I always stays inside memory.
+std::vector<uint8_t> generate_program(uint32_t seed) {
+    const uint16_t UNITS = 96;
+
+    const uint16_t SUBROUTINE = 0x200 + 6 * UNITS;
+
+    std::mt19937 generator(seed);
+    std::vector<uint16_t> opcodes;
+
+    for (uint16_t unit = 0; unit < UNITS - 1; unit++) {
+        uint16_t x = generator() % 16 << 8;
+        uint16_t y = generator() % 16 << 4;
+        uint16_t kk = generator() & 0xFF;
+        uint16_t target = 0x200 + 6 * (generator() % UNITS);
+        uint16_t data = 0x800 + generator() % 0x400;
+        static const uint16_t alu[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+        uint16_t branches[] = {uint16_t(0x3000 | kk), uint16_t(0x4000 | kk), 0x5000, 0x9000};
+
+        switch (generator() % 15) {
+            case 0:
+            case 1:
+                opcodes.insert(opcodes.end(), {uint16_t(0x6000 | x | kk), uint16_t(0x7000 | (x ^ 0x100) | kk),
+                                               uint16_t(0x8000 | x | y | alu[generator() % 9])});
+                break;
+            case 2:
+            case 3:
+                opcodes.insert(opcodes.end(), {uint16_t(0x8004 | x | y), uint16_t(0x8005 | y >> 4 << 8 | x >> 4),
+                                               uint16_t(0x8000 | x | y | alu[generator() % 9])});
+                break;
+            case 4:
+                opcodes.insert(opcodes.end(), {uint16_t(branches[generator() % 4] | x | y), uint16_t(0x1000 | target),
+                                               uint16_t(0x7000 | x | kk)});
+                break;
+            case 5:
+                opcodes.insert(opcodes.end(), {uint16_t(0xC000 | x | kk), uint16_t(0x4000 | x | (kk & 0x0F)),
+                                               uint16_t(0x8002 | x | y)});
+                break;
+            case 6:
+                opcodes.insert(opcodes.end(), {uint16_t(0xF029 | x), uint16_t(0xD005 | x | y), uint16_t(0x7000 | x | kk)});
+                break;
+            case 7: {
+                static const uint16_t stores[] = {0xF055, 0xF065, 0xF033};
+                opcodes.insert(opcodes.end(), {uint16_t(0xA000 | data), uint16_t(stores[generator() % 3] | x),
+                                               uint16_t(0xA000 | data)});
+                break;
+            }
+            case 8:
+                opcodes.insert(opcodes.end(), {uint16_t(0xF015 | x), uint16_t(0xF007 | y << 4), uint16_t(0xF018 | x)});
+                break;
+            case 9:
+            case 10:
+                opcodes.insert(opcodes.end(), {uint16_t(0x2000 | SUBROUTINE), uint16_t(0x7000 | x | kk),
+                                               uint16_t(0x8000 | x | y | alu[generator() % 9])});
+                break;
+            case 11:
+                opcodes.insert(opcodes.end(), {0x00E0, uint16_t(0xF029 | x), uint16_t(0xD005 | x | y)});
+                break;
+            case 12: {
+                // Skips ahead by up to 15 units, never past the last one, so it can't close a loop.
+                uint16_t skipped = generator() % std::min(16, UNITS - 1 - unit);
+                opcodes.insert(opcodes.end(), {uint16_t(0x6000 | 6 * skipped), uint16_t(0xB000 | (0x200 + 6 * (unit + 1))),
+                                               uint16_t(0x7000 | x | kk)});
+                break;
+            }
+            case 13: {
+                // Key waits end the slice, so only one in four of these units has one.
+                uint16_t key = generator() % 4 == 0 ? 0xF00A : 0xE09E;
+                opcodes.insert(opcodes.end(), {uint16_t(key | x), uint16_t(0x7000 | x | kk), uint16_t(0x8003 | x | y)});
+                break;
+            }
+            default:
+                opcodes.insert(opcodes.end(), {uint16_t((generator() % 2 ? 0xE09E : 0xE0A1) | x), uint16_t(0x7000 | x | kk),
+                                               uint16_t(0x6000 | y << 4 | kk)});
+        }
+    }
+    opcodes.insert(opcodes.end(), {0x1200, 0x1200, 0x1200});
+    opcodes.insert(opcodes.end(), {0x8014, 0x7101, 0x00EE});
+
+    std::vector<uint8_t> program;
+    for (auto opcode : opcodes) {
+        program.push_back(opcode >> 8);
+        program.push_back(opcode & 0xFF);
+    }
+
+    return program;
+}
+
+struct Scalar {
+    std::unique_ptr<NullRender> render_ptr;
+    std::unique_ptr<Framebuffer> framebuffer_ptr;
+    std::unique_ptr<Interpreter> interpreter_ptr;
+};
+
+// The same machines as the batch, one scalar CommandExecutor interpreter each.
+std::vector<Scalar> scalar_machines(const std::vector<uint8_t> &program, const std::vector<uint64_t> &seeds) {
+    std::vector<Scalar> machines(seeds.size());
+
+    for (size_t i = 0; i < seeds.size(); i++) {
+        auto &machine = machines[i];
+        machine.render_ptr = std::make_unique<NullRender>();
+        machine.framebuffer_ptr = std::make_unique<Framebuffer>(machine.render_ptr.get());
+        machine.interpreter_ptr = std::make_unique<Interpreter>(machine.framebuffer_ptr.get());
+        machine.interpreter_ptr->load(program);
+        machine.interpreter_ptr->random.seed(seeds[i]);
+        machine.interpreter_ptr->key_pressed(i % 16);
+    }
+
+    return machines;
+}
+
+std::unique_ptr<BatchExecutor> batch_machines(const std::vector<uint8_t> &program, const std::vector<uint64_t> &seeds) {
+    auto batch = std::make_unique<BatchExecutor>(seeds.size());
+    batch->load(program);
+
+    for (size_t i = 0; i < seeds.size(); i++) {
+        batch->seed(i, seeds[i]);
+        batch->key_pressed(i, i % 16);
+    }
+
+    return batch;
+}
+
+bool is_same(BatchExecutor &batch, std::vector<Scalar> &machines) {
+    NullRender render;
+    Framebuffer screen(&render);
+    BaseInterpreter state;
+    state.framebuffer = &screen;
+
+    for (size_t i = 0; i < machines.size(); i++) {
+        auto &interpreter = *machines[i].interpreter_ptr;
+        batch.extract(i, state);
+
+        if (state.memory != interpreter.memory || state.registers != interpreter.registers ||
+            state.stack != interpreter.stack || state.stack_pointer != interpreter.stack_pointer ||
+            state.index_register != interpreter.index_register || state.program_counter != interpreter.program_counter ||
+            state.delay_timer != interpreter.delay_timer || state.sound_timer != interpreter.sound_timer ||
+            state.random.state() != interpreter.random.state() || screen.rows() != machines[i].framebuffer_ptr->rows()) {
+            std::cout << "Batch mismatch in machine " << i << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Runs budget sized slices with a timer tick after each, as the scheduler would. Machines
+// waiting on Fx0A get their key pressed again between slices.
+double measure_scalar(std::vector<Scalar> &machines, uint32_t budget, size_t slices, uint64_t &executed) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t slice = 0; slice < slices; slice++) {
+        for (size_t i = 0; i < machines.size(); i++) {
+            auto &interpreter = *machines[i].interpreter_ptr;
+            executed += interpreter.run(budget);
+            interpreter.update_timers();
+            if (interpreter.is_stop_execution()) {
+                interpreter.key_pressed(i % 16);
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+double measure_batch(BatchExecutor &batch, uint32_t budget, size_t slices, uint64_t &executed) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t slice = 0; slice < slices; slice++) {
+        executed += batch.run(budget);
+        batch.update_timers();
+        for (size_t lane = 0; lane < batch.size(); lane++) {
+            if (batch.is_stop_execution(lane)) {
+                batch.key_pressed(lane, lane % 16);
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Converged machines share a seed and follow the same path; seeded ones get their own seed, so
+// Cxkk sends them down different branches.
+bool compare(const std::string &name, const std::vector<uint8_t> &program, const std::vector<uint64_t> &seeds) {
+    const uint32_t BUDGET = 1000;
+    const size_t CHECK_SLICES = 50;
+    const size_t SLICES = 200;
+
+    auto machines = scalar_machines(program, seeds);
+    auto batch = batch_machines(program, seeds);
+
+    uint64_t scalar_executed = 0;
+    uint64_t batch_executed = 0;
+    for (size_t slice = 0; slice < CHECK_SLICES; slice++) {
+        measure_scalar(machines, BUDGET, 1, scalar_executed);
+        measure_batch(*batch, BUDGET, 1, batch_executed);
+
+        if (scalar_executed != batch_executed || !is_same(*batch, machines)) {
+            std::cout << name << ": diverged after " << slice + 1 << " slices" << std::endl;
+            return false;
+        }
+    }
+
+    scalar_executed = 0;
+    batch_executed = 0;
+    auto scalar_time = measure_scalar(machines, BUDGET, SLICES, scalar_executed);
+    auto batch_time = measure_batch(*batch, BUDGET, SLICES, batch_executed);
+
+    auto scalar_mips = scalar_executed / scalar_time / 1e6;
+    auto batch_mips = batch_executed / batch_time / 1e6;
+    std::cout << name << ": scalar " << scalar_mips << " MIPS, batch " << batch_mips << " MIPS, speedup "
+              << batch_mips / scalar_mips << "x" << std::endl;
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t instances = argc > 1 ? std::stoul(argv[1]) : 32;
+    auto program = generate_program(0xBA7C);
+
+    std::cout << "instruction set: " << BatchExecutor::instruction_set() << ", machines: " << instances << std::endl;
+
+    std::vector<uint64_t> converged(instances, static_cast<uint64_t>(Random::DEFAULT_SEED));
+    std::vector<uint64_t> seeded(instances);
+    for (size_t i = 0; i < instances; i++) {
+        seeded[i] = i;
+    }
+
+    if (!compare("converged", program, converged) || !compare("seeded", program, seeded)) {
+        return 1;
+    }
+
+    return 0;
+}
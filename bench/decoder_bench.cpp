@@ -0,0 +1,100 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "lib/instruction.hpp"
+#include "lib/decoder.hpp"
+#include "lib/functions.hpp"
+
+// Opcode families weighted roughly like the instruction profile of common game ROMs.
+struct OpcodeFamily {
+    uint16_t base;
+    uint16_t random_mask;
+    uint32_t weight;
+};
+
+const auto families = std::array<OpcodeFamily, 24>{{
+    {0x6000, 0x0FFF, 150}, // LD Vx, byte
+    {0x7000, 0x0FFF, 110}, // ADD Vx, byte
+    {0xA000, 0x0FFF, 100}, // LD I, addr
+    {0xD000, 0x0FFF, 80},  // DRW
+    {0x3000, 0x0FFF, 70},  // SE Vx, byte
+    {0x4000, 0x0FFF, 50},  // SNE Vx, byte
+    {0x1000, 0x0FFF, 90},  // JP addr
+    {0x2000, 0x0FFF, 40},  // CALL addr
+    {0x00EE, 0x0000, 40},  // RET
+    {0x00E0, 0x0000, 5},   // CLS
+    {0x8000, 0x0FF0, 25},  // LD Vx, Vy
+    {0x8002, 0x0FF0, 15},  // AND Vx, Vy
+    {0x8004, 0x0FF0, 20},  // ADD Vx, Vy
+    {0x8005, 0x0FF0, 10},  // SUB Vx, Vy
+    {0xC000, 0x0FFF, 25},  // RND
+    {0xE09E, 0x0F00, 15},  // SKP
+    {0xE0A1, 0x0F00, 20},  // SKNP
+    {0xF007, 0x0F00, 30},  // LD Vx, DT
+    {0xF015, 0x0F00, 20},  // LD DT, Vx
+    {0xF01E, 0x0F00, 20},  // ADD I, Vx
+    {0xF029, 0x0F00, 10},  // LD F, Vx
+    {0xF033, 0x0F00, 5},   // LD B, Vx
+    {0xF065, 0x0F00, 10},  // LD Vx, [I]
+    {0x5001, 0x0FF0, 2}    // unknown
+}};
+
+std::vector<uint16_t> generate_workload(size_t size) {
+    std::mt19937 generator(0xC8);
+    std::vector<uint32_t> weights;
+    for (auto &family : families) {
+        weights.push_back(family.weight);
+    }
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    std::vector<uint16_t> opcodes(size);
+    for (auto &opcode : opcodes) {
+        auto &family = families[pick(generator)];
+        opcode = family.base | (generator() & family.random_mask);
+    }
+
+    return opcodes;
+}
+
+template <typename Decode>
+double measure(const std::vector<uint16_t> &opcodes, size_t rounds, Decode decode, uintptr_t &checksum) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t round = 0; round < rounds; round++) {
+        for (auto opcode : opcodes) {
+            checksum += reinterpret_cast<uintptr_t>(decode(opcode));
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto nanoseconds = std::chrono::duration<double, std::nano>(end - begin).count();
+
+    return nanoseconds / (opcodes.size() * rounds);
+}
+
+int main() {
+    const size_t WORKLOAD_SIZE = 1 << 20;
+    const size_t ROUNDS = 20;
+
+    auto opcodes = generate_workload(WORKLOAD_SIZE);
+    auto &decoder = Decoder::instance();
+
+    for (auto opcode : opcodes) {
+        if (decoder.decode(opcode) != find_instruction(opcode)) {
+            std::cout << "Decoder mismatch at opcode " << to_hex(opcode) << std::endl;
+            return 1;
+        }
+    }
+
+    uintptr_t checksum = 0;
+    auto linear = measure(opcodes, ROUNDS, find_instruction, checksum);
+    auto table = measure(opcodes, ROUNDS, [&](uint16_t opcode) { return decoder.decode(opcode); }, checksum);
+
+    std::cout << "linear search: " << linear << " ns/opcode" << std::endl;
+    std::cout << "dispatch table: " << table << " ns/opcode" << std::endl;
+    std::cout << "speedup: " << linear / table << "x" << std::endl;
+    std::cout << "checksum: " << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "lib/framebuffer.hpp"
+#include "lib/null_render.hpp"
+
+// The byte per pixel framebuffer the packed one replaced, kept here as the baseline. It has no
+// dirty tracking, so every draw repaints the whole screen.
+class ByteFramebuffer {
+private:
+    BaseRender *render;
+    std::vector<uint8_t> buffer;
+    DirtyRegion everything;
+
+    bool draw_pixel(uint16_t x, uint16_t y) {
+        while (x > BaseRender::SCREEN_WIDTH - 1) x -= BaseRender::SCREEN_WIDTH;
+        while (y > BaseRender::SCREEN_HEIGHT - 1) y -= BaseRender::SCREEN_HEIGHT;
+
+        size_t position = y * BaseRender::SCREEN_WIDTH + x;
+        buffer[position] ^= 0x1;
+
+        return !buffer[position];
+    }
+
+public:
+    ByteFramebuffer(BaseRender *render) : render(render) {
+        buffer.resize(BaseRender::SCREEN_WIDTH * BaseRender::SCREEN_HEIGHT);
+        everything.add(0xFFFFFFFF, 0, BaseRender::SCREEN_WIDTH);
+    }
+
+    const std::vector<uint8_t>& pixels() const {
+        return buffer;
+    }
+
+    uint8_t draw(uint8_t *memory, uint8_t len, uint8_t x, uint8_t y) {
+        bool is_cleared = false;
+
+        for (auto n = 0; n < len; n++) {
+            auto pixel = memory[n];
+
+            for (auto b = 0; b < 8; b++) {
+                if (pixel & 0x80) {
+                    is_cleared = draw_pixel(x + b, y + n) || is_cleared;
+                }
+
+                pixel = pixel << 1;
+            }
+        }
+
+        render->draw(buffer, everything);
+        return is_cleared ? 1 : 0;
+    }
+};
+
+struct Sprite {
+    uint16_t address;
+    uint8_t len;
+    uint8_t x;
+    uint8_t y;
+};
+
+std::vector<Sprite> generate_workload(size_t size) {
+    std::mt19937 generator(0xD0);
+    std::vector<Sprite> sprites(size);
+
+    for (auto &sprite : sprites) {
+        sprite.address = generator() % (4096 - 16);
+        sprite.len = 1 + generator() % 15;
+        sprite.x = generator();
+        sprite.y = generator();
+    }
+
+    return sprites;
+}
+
+template <typename Target>
+double measure(Target &target, std::vector<uint8_t> &memory, const std::vector<Sprite> &sprites, size_t rounds, uint32_t &collisions) {
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t round = 0; round < rounds; round++) {
+        for (auto &sprite : sprites) {
+            collisions += target.draw(&memory[sprite.address], sprite.len, sprite.x, sprite.y);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto nanoseconds = std::chrono::duration<double, std::nano>(end - begin).count();
+
+    return nanoseconds / (sprites.size() * rounds);
+}
+
+int main() {
+    const size_t WORKLOAD_SIZE = 1 << 16;
+    const size_t ROUNDS = 20;
+
+    std::mt19937 generator(0x8D);
+    std::vector<uint8_t> memory(4096);
+    for (auto &byte : memory) {
+        byte = generator();
+    }
+
+    auto sprites = generate_workload(WORKLOAD_SIZE);
+    NullRender render;
+
+    ByteFramebuffer bytes(&render);
+    Framebuffer packed(&render);
+    for (auto &sprite : sprites) {
+        auto expected = bytes.draw(&memory[sprite.address], sprite.len, sprite.x, sprite.y);
+        if (packed.draw(&memory[sprite.address], sprite.len, sprite.x, sprite.y) != expected ||
+            packed.pixels() != bytes.pixels()) {
+            std::cout << "Framebuffer mismatch drawing at " << +sprite.x << ", " << +sprite.y << std::endl;
+            return 1;
+        }
+    }
+
+    uint32_t collisions = 0;
+    auto byte_time = measure(bytes, memory, sprites, ROUNDS, collisions);
+    auto packed_time = measure(packed, memory, sprites, ROUNDS, collisions);
+
+    std::cout << "byte per pixel: " << byte_time << " ns/DRW" << std::endl;
+    std::cout << "packed rows: " << packed_time << " ns/DRW" << std::endl;
+    std::cout << "speedup: " << byte_time / packed_time << "x" << std::endl;
+    std::cout << "collisions: " << collisions << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,311 @@
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include "instruction.hpp"
+#include "decoder.hpp"
+#include "functions.hpp"
+
+#pragma once
+
+// Static recompiler: recovers the control flow of a ROM from 0x200 and writes a C++ translation
+// unit with one function per reachable basic block, for AotExecutor to dispatch between.
+class AotCompiler {
+public:
+    static const uint16_t LOAD_ADDRESS = 0x200;
+
+    AotCompiler(const std::vector<uint8_t> &rom);
+
+    size_t blocks_count() const;
+    void write(std::ostream &out, const std::string &rom_name) const;
+
+private:
+    struct Block {
+        uint16_t start;
+        uint16_t end;
+        bool stops;
+    };
+
+    std::vector<uint8_t> rom;
+    std::map<uint16_t, Block> blocks;
+    const Decoder &decoder = Decoder::instance();
+
+    bool contains(uint32_t address) const;
+    uint16_t opcode_at(uint16_t address) const;
+    void discover();
+    bool write_instruction(std::ostream &out, uint16_t address, uint16_t opcode, const Instruction *instruction) const;
+};
+
+AotCompiler::AotCompiler(const std::vector<uint8_t> &rom) : rom(rom) {
+    discover();
+}
+
+size_t AotCompiler::blocks_count() const {
+    return blocks.size();
+}
+
+bool AotCompiler::contains(uint32_t address) const {
+    return address >= LOAD_ADDRESS && address + 1 < LOAD_ADDRESS + rom.size();
+}
+
+uint16_t AotCompiler::opcode_at(uint16_t address) const {
+    return rom[address - LOAD_ADDRESS] << 8 | rom[address - LOAD_ADDRESS + 1];
+}
+
+// Walks every statically known successor: jump and call targets, return sites, both sides of
+// skips and the instruction after Fx0A/DRW/CLS/stores. Bnnn and RET targets are left to the
+// runtime fallback. Blocks end where the engines stop or where code may rewrite itself.
+void AotCompiler::discover() {
+    std::vector<uint16_t> pending = {LOAD_ADDRESS};
+
+    while (!pending.empty()) {
+        uint16_t start = pending.back();
+        pending.pop_back();
+
+        if (!contains(start) || blocks.count(start) != 0) {
+            continue;
+        }
+
+        Block block = {start, start, false};
+        std::vector<uint16_t> successors;
+        bool terminated = false;
+
+        while (!terminated && contains(block.end)) {
+            uint16_t address = block.end;
+            uint16_t opcode = opcode_at(address);
+            auto instruction = decoder.decode(opcode);
+            block.end += 2;
+
+            if (instruction == nullptr) {
+                break;
+            }
+
+            switch (*instruction) {
+                case ::JP_ADDR:
+                    successors.push_back(opcode & 0x0FFF);
+                    terminated = true;
+                    break;
+                case ::CALL_ADDR:
+                    successors.push_back(opcode & 0x0FFF);
+                    successors.push_back(address + 2);
+                    terminated = true;
+                    break;
+                case ::RET:
+                case ::JP_V0_ADDR:
+                    terminated = true;
+                    break;
+                case ::SE_VX_BYTE:
+                case ::SNE_VX_BYTE:
+                case ::SE_VX_VY:
+                case ::SNE_VX_VY:
+                case ::SKP_VX:
+                case ::SKPN_VX:
+                    successors.push_back(address + 2);
+                    successors.push_back(address + 4);
+                    terminated = true;
+                    break;
+                case ::CLS:
+                case ::DRW_VX_VY_N:
+                case ::LD_VX_K:
+                    successors.push_back(address + 2);
+                    block.stops = true;
+                    terminated = true;
+                    break;
+                case ::LD_B_VX:
+                case ::LD_I_VX:
+                    successors.push_back(address + 2);
+                    terminated = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (!terminated && contains(block.end)) {
+            successors.push_back(block.end);
+        }
+
+        blocks[start] = block;
+        pending.insert(pending.end(), successors.begin(), successors.end());
+    }
+}
+
+void AotCompiler::write(std::ostream &out, const std::string &rom_name) const {
+    out << "// Generated by chip8_aot from " << rom_name << ". Do not edit.\n";
+    out << "#include \"lib/aot_runtime.hpp\"\n\n";
+    out << "namespace {\n\n";
+
+    out << "const uint8_t image[] = {";
+    for (size_t i = 0; i < rom.size(); i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << to_hex(rom[i]) << ",";
+    }
+    out << "\n};\n";
+
+    for (auto &entry : blocks) {
+        auto &block = entry.second;
+
+        // Only blocks with an instruction left to CommandExecutor use e.
+        out << "\nuint32_t block_" << to_hex(block.start) << "(BaseInterpreter &s, [[maybe_unused]] CommandExecutor &e) {\n";
+
+        bool sets_program_counter = false;
+        for (uint16_t address = block.start; address < block.end; address += 2) {
+            auto opcode = opcode_at(address);
+            sets_program_counter = write_instruction(out, address, opcode, decoder.decode(opcode));
+        }
+
+        if (!sets_program_counter) {
+            out << "    s.program_counter = " << to_hex(block.end) << ";\n";
+        }
+
+        out << "    return " << (block.end - block.start) / 2 << ";\n";
+        out << "}\n";
+    }
+
+    out << "\nconst AotBlock blocks[] = {\n";
+    for (auto &entry : blocks) {
+        auto &block = entry.second;
+
+        out << "    {" << to_hex(block.start) << ", " << block.end - block.start << ", "
+            << (block.end - block.start) / 2 << ", " << (block.stops ? "true" : "false")
+            << ", &block_" << to_hex(block.start) << "},\n";
+    }
+    out << "};\n\n";
+    out << "}\n\n";
+
+    out << "const AotProgram aot_program(image, sizeof(image), blocks, sizeof(blocks) / sizeof(blocks[0]));\n";
+}
+
+// Mirrors the CommandExecutor handlers. Instructions touching the screen, the RNG, key waits and
+// stores go through CommandExecutor itself with the program counter set to their address.
+// Returns whether the emitted code leaves the program counter updated.
+bool AotCompiler::write_instruction(std::ostream &out, uint16_t address, uint16_t opcode, const Instruction *instruction) const {
+    auto x = to_hex<uint8_t>((opcode & 0x0F00) >> 8);
+    auto y = to_hex<uint8_t>((opcode & 0x00F0) >> 4);
+    auto kk = to_hex<uint8_t>(opcode & 0x00FF);
+    auto nnn = to_hex<uint16_t>(opcode & 0x0FFF);
+    auto next = to_hex<uint16_t>(address + 2);
+    auto skip = to_hex<uint16_t>(address + 4);
+    auto vx = "s.registers[" + x + "]";
+    auto vy = "s.registers[" + y + "]";
+
+    out << "    // " << to_hex(address) << ": " << to_hex(opcode) << "\n";
+
+    if (instruction == nullptr) {
+        out << "    s.program_counter = " << to_hex(address) << ";\n";
+        out << "    e.execute(" << to_hex(opcode) << ");\n";
+        return true;
+    }
+
+    switch (*instruction) {
+        case ::RET:
+            out << "    s.program_counter = s.stack[--s.stack_pointer];\n";
+            return true;
+        case ::JP_ADDR:
+            out << "    s.program_counter = " << nnn << ";\n";
+            return true;
+        case ::CALL_ADDR:
+            out << "    s.stack[s.stack_pointer++] = " << next << ";\n";
+            out << "    s.program_counter = " << nnn << ";\n";
+            return true;
+        case ::SE_VX_BYTE:
+            out << "    s.program_counter = " << vx << " == " << kk << " ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::SNE_VX_BYTE:
+            out << "    s.program_counter = " << vx << " != " << kk << " ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::SE_VX_VY:
+            out << "    s.program_counter = " << vx << " == " << vy << " ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::SNE_VX_VY:
+            out << "    s.program_counter = " << vx << " != " << vy << " ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::SKP_VX:
+            out << "    s.program_counter = s.keyboard[" << vx << " & 0xF] ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::SKPN_VX:
+            out << "    s.program_counter = !s.keyboard[" << vx << " & 0xF] ? " << skip << " : " << next << ";\n";
+            return true;
+        case ::LD_VX_BYTE:
+            out << "    " << vx << " = " << kk << ";\n";
+            break;
+        case ::ADD_VX_BYTE:
+            out << "    " << vx << " += " << kk << ";\n";
+            break;
+        case ::LD_VX_VY:
+            out << "    " << vx << " = " << vy << ";\n";
+            break;
+        case ::OR_VX_VY:
+            out << "    " << vx << " |= " << vy << ";\n";
+            break;
+        case ::AND_VX_VY:
+            out << "    " << vx << " &= " << vy << ";\n";
+            break;
+        case ::XOR_VX_VY:
+            out << "    " << vx << " ^= " << vy << ";\n";
+            break;
+        case ::ADD_VX_VY_CARRY:
+            out << "    {\n";
+            out << "        uint8_t vx = " << vx << ", vy = " << vy << ";\n";
+            out << "        s.registers[0xF] = vy > (0xFF - vx) ? 1 : 0;\n";
+            out << "        " << vx << " += " << vy << ";\n";
+            out << "    }\n";
+            break;
+        case ::SUB_VX_VY:
+            out << "    {\n";
+            out << "        uint8_t vx = " << vx << ", vy = " << vy << ";\n";
+            out << "        s.registers[0xF] = vx > vy ? 1 : 0;\n";
+            out << "        " << vx << " -= " << vy << ";\n";
+            out << "    }\n";
+            break;
+        case ::SHR_VX_VY:
+            out << "    s.registers[0xF] = " << vx << " & 0x1;\n";
+            out << "    " << vx << " >>= 1;\n";
+            break;
+        case ::SUBN_VX_VY:
+            out << "    {\n";
+            out << "        uint8_t vx = " << vx << ", vy = " << vy << ";\n";
+            out << "        s.registers[0xF] = vy > vx ? 1 : 0;\n";
+            out << "        " << vx << " = vy - vx;\n";
+            out << "    }\n";
+            break;
+        case ::SHL_VX:
+            out << "    s.registers[0xF] = " << vx << " >> 7;\n";
+            out << "    " << vx << " <<= 1;\n";
+            break;
+        case ::LD_I_ADDR:
+            out << "    s.index_register = " << nnn << ";\n";
+            break;
+        case ::JP_V0_ADDR:
+            out << "    s.program_counter = " << nnn << " + s.registers[0x0];\n";
+            return true;
+        case ::LD_VX_DT:
+            out << "    " << vx << " = s.delay_timer;\n";
+            break;
+        case ::LD_DT_VX:
+            out << "    s.delay_timer = " << vx << ";\n";
+            break;
+        case ::LD_ST_VX:
+            out << "    s.sound_timer = " << vx << ";\n";
+            break;
+        case ::ADD_I_VX:
+            out << "    {\n";
+            out << "        uint8_t vx = " << vx << ";\n";
+            out << "        s.registers[0xF] = s.index_register + vx > 0x0FFF ? 1 : 0;\n";
+            out << "        s.index_register += vx;\n";
+            out << "    }\n";
+            break;
+        case ::LD_F_VX:
+            out << "    s.index_register = " << vx << " * 5;\n";
+            break;
+        case ::LD_VX_I:
+            out << "    std::memcpy(&s.registers[0], &s.memory[s.index_register], " << ((opcode & 0x0F00) >> 8) + 1 << ");\n";
+            out << "    s.index_register += " << ((opcode & 0x0F00) >> 8) + 1 << ";\n";
+            break;
+        default:
+            out << "    s.program_counter = " << to_hex(address) << ";\n";
+            out << "    e.execute(" << to_hex(opcode) << ");\n";
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,96 @@
+#include <array>
+#include <vector>
+#include <cstring>
+#include "base_interpreter.hpp"
+#include "command_executor.hpp"
+
+#pragma once
+
+// A basic block compiled ahead of time by chip8_aot. The code runs count instructions against
+// the interpreter state and leaves the program counter at the block's successor.
+struct AotBlock {
+    uint16_t start;
+    uint16_t length;
+    uint32_t count;
+    bool stops;
+    uint32_t (*code)(BaseInterpreter &s, CommandExecutor &e);
+};
+
+// Everything chip8_aot emits for one ROM: its image (loaded at 0x200) and the compiled blocks.
+class AotProgram {
+public:
+    static const uint16_t LOAD_ADDRESS = 0x200;
+
+    AotProgram(const uint8_t *image, size_t image_size, const AotBlock *blocks, size_t blocks_count);
+
+    std::vector<uint8_t> rom() const;
+    const AotBlock* block(uint16_t address) const;
+    bool is_unmodified(const BaseInterpreter &state, const AotBlock &block) const;
+
+private:
+    const uint8_t *image;
+    size_t image_size;
+    std::array<const AotBlock*, 4096> table;
+};
+
+// Runs the compiled blocks and falls back to CommandExecutor for addresses the compiler never
+// reached (Bnnn targets, data executed as code) and for blocks whose bytes were overwritten.
+class AotExecutor {
+public:
+    AotExecutor(BaseInterpreter *interpreter, CommandExecutor *executor, const AotProgram *program);
+
+    uint32_t run(uint32_t budget);
+
+private:
+    static const uint16_t ADDRESS_MASK = 0x0FFF;
+
+    BaseInterpreter *interpreter_ptr;
+    CommandExecutor *executor_ptr;
+    const AotProgram *program_ptr;
+};
+
+AotProgram::AotProgram(const uint8_t *image, size_t image_size, const AotBlock *blocks, size_t blocks_count) :
+        image(image), image_size(image_size) {
+    table.fill(nullptr);
+
+    for (size_t i = 0; i < blocks_count; i++) {
+        table[blocks[i].start] = &blocks[i];
+    }
+}
+
+std::vector<uint8_t> AotProgram::rom() const {
+    return std::vector<uint8_t>(image, image + image_size);
+}
+
+const AotBlock* AotProgram::block(uint16_t address) const {
+    return table[address];
+}
+
+bool AotProgram::is_unmodified(const BaseInterpreter &state, const AotBlock &block) const {
+    return std::memcmp(&state.memory[block.start], &image[block.start - LOAD_ADDRESS], block.length) == 0;
+}
+
+AotExecutor::AotExecutor(BaseInterpreter *interpreter, CommandExecutor *executor, const AotProgram *program) :
+        interpreter_ptr(interpreter), executor_ptr(executor), program_ptr(program) {
+}
+
+uint32_t AotExecutor::run(uint32_t budget) {
+    uint32_t executed = 0;
+
+    while (executed < budget && interpreter_ptr->stop_execution_flag != 0x1) {
+        auto block = program_ptr->block(interpreter_ptr->program_counter & ADDRESS_MASK);
+
+        if (block == nullptr || block->count > budget - executed || !program_ptr->is_unmodified(*interpreter_ptr, *block)) {
+            executor_ptr->step();
+            executed++;
+            continue;
+        }
+
+        executed += block->code(*interpreter_ptr, *executor_ptr);
+        if (block->stops) {
+            break;
+        }
+    }
+
+    return executed;
+}
@@ -1,6 +1,11 @@
 #include <array>
+#include <ostream>
+#include "random.hpp"
 
 #pragma once
+
+class Framebuffer;
+
 class BaseInterpreter {
 public:
     std::array<uint8_t, 4096> memory;
@@ -19,4 +24,9 @@ public:
     uint8_t continue_execution_key;
 
     Framebuffer *framebuffer;
+    Random random;
+
+    // Unknown opcodes are counted per instance and only reported if log is set.
+    uint64_t unknown_opcodes;
+    std::ostream *log;
 };
\ No newline at end of file
@@ -1,9 +1,69 @@
 #include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#pragma once
+
+// The part of the screen that changed since the last present: a bit per row plus the bounding
+// box of every change, with right and bottom exclusive.
+struct DirtyRegion {
+    uint32_t rows = 0;
+    uint8_t left = 0;
+    uint8_t top = 0;
+    uint8_t right = 0;
+    uint8_t bottom = 0;
+
+    bool empty() const;
+    void add(uint32_t rows, uint8_t x, uint8_t width);
+    void clear();
+};
 
 class BaseRender {
 public:
     static const uint8_t SCREEN_WIDTH = 64;
     static const uint8_t SCREEN_HEIGHT = 32;
 
-    virtual void draw(const std::vector<uint8_t> &memory) = 0;
-};
\ No newline at end of file
+    virtual ~BaseRender() = default;
+
+    virtual void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) = 0;
+};
+
+bool DirtyRegion::empty() const {
+    return rows == 0;
+}
+
+// Marks width pixels from column x in every row set in the rows mask; a span running off the
+// right edge wraps, which widens the box to the whole row.
+void DirtyRegion::add(uint32_t rows, uint8_t x, uint8_t width) {
+    if (rows == 0) {
+        return;
+    }
+
+    uint8_t begin = x;
+    uint8_t end = x + width;
+    if (end > BaseRender::SCREEN_WIDTH) {
+        begin = 0;
+        end = BaseRender::SCREEN_WIDTH;
+    }
+
+    uint8_t first = __builtin_ctz(rows);
+    uint8_t last = 32 - __builtin_clz(rows);
+
+    if (empty()) {
+        left = begin;
+        right = end;
+        top = first;
+        bottom = last;
+    } else {
+        left = std::min(left, begin);
+        right = std::max(right, end);
+        top = std::min(top, first);
+        bottom = std::max(bottom, last);
+    }
+
+    this->rows |= rows;
+}
+
+void DirtyRegion::clear() {
+    *this = DirtyRegion();
+}
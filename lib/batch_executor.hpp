@@ -0,0 +1,620 @@
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include "base_interpreter.hpp"
+#include "framebuffer.hpp"
+#include "null_render.hpp"
+#include "random.hpp"
+#include "instruction.hpp"
+#include "decoder.hpp"
+#include "lane_vector.hpp"
+#include "fonts.hpp"
+
+#pragma once
+
+// Runs many CHIP-8 machines in lockstep, one per lane, with all state stored as structure of
+// arrays: register Vx of every machine is one row, and so is every memory address and timer.
+// Each step takes the machines at the lowest program counter that fetch the same opcode and
+// runs it for all of them at once. Register and timer work is done a LaneVector at a time;
+// draws, Cxkk, keys, the stack and memory stores go machine by machine. Machines that took a
+// different branch wait until the lowest program counter reaches them again.
+class BatchExecutor {
+public:
+    BatchExecutor(size_t instances);
+
+    static const char* instruction_set();
+    size_t size() const;
+
+    void load(const std::vector<uint8_t> &program);
+    void load(size_t lane, const std::vector<uint8_t> &program);
+    void seed(size_t lane, uint64_t seed);
+
+    uint64_t run(uint32_t budget);
+    void update_timers();
+
+    void key_pressed(size_t lane, uint8_t code);
+    void key_released(size_t lane, uint8_t code);
+    bool is_stop_execution(size_t lane) const;
+
+    uint32_t executed(size_t lane) const;
+    const Framebuffer& framebuffer(size_t lane) const;
+    void extract(size_t lane, BaseInterpreter &interpreter) const;
+
+private:
+    typedef LaneVector Vector;
+
+    static constexpr uint16_t ADDRESS_MASK = 0x0FFF;
+    static constexpr uint16_t PROGRAM_START = 0x200;
+    static constexpr size_t MEMORY_SIZE = 4096;
+    static constexpr size_t STACK_SIZE = 16;
+
+    size_t instances;
+    size_t lanes;
+
+    // Row major: memory[address * lanes + lane], registers[x * lanes + lane] and so on.
+    std::vector<uint8_t> memory;
+    std::vector<uint8_t> registers;
+    std::vector<uint16_t> stack;
+    std::vector<uint8_t> keyboard;
+
+    std::vector<uint8_t> stack_pointer;
+    std::vector<uint8_t> sound_timer;
+    std::vector<uint8_t> delay_timer;
+    std::vector<uint16_t> index_register;
+    std::vector<uint16_t> program_counter;
+
+    std::vector<uint8_t> stop_execution_flag;
+    std::vector<uint8_t> continue_execution_key;
+    std::vector<uint64_t> unknown_opcodes;
+    std::vector<uint32_t> executed_count;
+    std::vector<Random> random;
+
+    NullRender render;
+    std::vector<std::unique_ptr<Framebuffer>> framebuffers;
+
+    // The lanes running the current opcode, and per lane skip conditions, as LaneVector masks.
+    std::vector<uint8_t> group;
+    std::vector<uint8_t> condition;
+
+    const Decoder &decoder = Decoder::instance();
+
+    uint8_t* row(std::vector<uint8_t> &rows, size_t index);
+    Vector::Type load_row(std::vector<uint8_t> &rows, size_t index, size_t lane);
+
+    bool select(uint32_t budget, uint16_t &opcode);
+    void execute(uint16_t opcode);
+
+    template <typename Operation>
+    void assign(uint8_t *target, Operation operation);
+    template <typename Flag, typename Operation>
+    void arithmetic(uint8_t x, uint8_t y, Flag flag, Operation operation);
+    template <typename Condition>
+    void skip(Condition condition_operation);
+    void advance();
+    void jump(uint16_t address);
+
+    void draw(uint8_t x, uint8_t y, uint8_t n);
+    void store_bcd(uint8_t x);
+    void store_registers(uint8_t x);
+    void load_registers(uint8_t x);
+};
+
+// Lanes are padded to whole LaneVectors; the padding never runs.
+BatchExecutor::BatchExecutor(size_t instances) : instances(instances) {
+    lanes = (instances + Vector::WIDTH - 1) / Vector::WIDTH * Vector::WIDTH;
+
+    memory.assign(MEMORY_SIZE * lanes, 0x0);
+    registers.assign(16 * lanes, 0x0);
+    stack.assign(STACK_SIZE * lanes, 0x0);
+    keyboard.assign(16 * lanes, 0x0);
+
+    stack_pointer.assign(lanes, 0);
+    sound_timer.assign(lanes, 0);
+    delay_timer.assign(lanes, 0);
+    index_register.assign(lanes, 0);
+    program_counter.assign(lanes, PROGRAM_START);
+
+    stop_execution_flag.assign(lanes, 0x0);
+    continue_execution_key.assign(lanes, 0x0);
+    unknown_opcodes.assign(lanes, 0);
+    executed_count.assign(lanes, 0);
+    random.resize(lanes);
+
+    group.assign(lanes, 0x0);
+    condition.assign(lanes, 0x0);
+
+    for (size_t lane = 0; lane < instances; lane++) {
+        framebuffers.push_back(std::make_unique<Framebuffer>(&render));
+
+        for (size_t address = 0; address < fonts.size(); address++) {
+            memory[address * lanes + lane] = fonts[address];
+        }
+    }
+}
+
+const char* BatchExecutor::instruction_set() {
+    return Vector::name();
+}
+
+size_t BatchExecutor::size() const {
+    return instances;
+}
+
+void BatchExecutor::load(const std::vector<uint8_t> &program) {
+    for (size_t lane = 0; lane < instances; lane++) {
+        load(lane, program);
+    }
+}
+
+void BatchExecutor::load(size_t lane, const std::vector<uint8_t> &program) {
+    auto length = std::min(program.size(), MEMORY_SIZE - PROGRAM_START);
+
+    for (size_t i = 0; i < length; i++) {
+        memory[(PROGRAM_START + i) * lanes + lane] = program[i];
+    }
+}
+
+void BatchExecutor::seed(size_t lane, uint64_t seed) {
+    random[lane].seed(seed);
+}
+
+// Runs every machine for up to budget instructions, stopping early at a key wait like
+// Interpreter::run, and returns the total executed.
+uint64_t BatchExecutor::run(uint32_t budget) {
+    std::fill(executed_count.begin(), executed_count.end(), 0);
+
+    uint16_t opcode;
+    while (select(budget, opcode)) {
+        execute(opcode);
+
+        for (size_t lane = 0; lane < lanes; lane++) {
+            executed_count[lane] += group[lane] & 0x1;
+        }
+    }
+
+    uint64_t total = 0;
+    for (size_t lane = 0; lane < instances; lane++) {
+        total += executed_count[lane];
+    }
+
+    return total;
+}
+
+void BatchExecutor::update_timers() {
+    auto one = Vector::broadcast(0x1);
+    auto zero = Vector::broadcast(0x0);
+
+    for (size_t lane = 0; lane < lanes; lane += Vector::WIDTH) {
+        for (auto timers : {&delay_timer[lane], &sound_timer[lane]}) {
+            auto timer = Vector::load(timers);
+            Vector::store(timers, Vector::sub(timer, Vector::bit_and(Vector::greater(timer, zero), one)));
+        }
+    }
+}
+
+void BatchExecutor::key_pressed(size_t lane, uint8_t code) {
+    keyboard[code * lanes + lane] = 0x1;
+
+    if (stop_execution_flag[lane] == 0x1) {
+        registers[(continue_execution_key[lane] & 0xF) * lanes + lane] = code;
+        stop_execution_flag[lane] = 0x0;
+    }
+}
+
+void BatchExecutor::key_released(size_t lane, uint8_t code) {
+    keyboard[code * lanes + lane] = 0x0;
+}
+
+bool BatchExecutor::is_stop_execution(size_t lane) const {
+    return stop_execution_flag[lane] == 0x1;
+}
+
+// Instructions the lane executed in the last run.
+uint32_t BatchExecutor::executed(size_t lane) const {
+    return executed_count[lane];
+}
+
+const Framebuffer& BatchExecutor::framebuffer(size_t lane) const {
+    return *framebuffers[lane];
+}
+
+// Copies one machine out, e.g. to compare it with a scalar interpreter. The screen is copied
+// too when the interpreter has a framebuffer.
+void BatchExecutor::extract(size_t lane, BaseInterpreter &interpreter) const {
+    for (size_t address = 0; address < MEMORY_SIZE; address++) {
+        interpreter.memory[address] = memory[address * lanes + lane];
+    }
+    for (size_t i = 0; i < 16; i++) {
+        interpreter.registers[i] = registers[i * lanes + lane];
+        interpreter.stack[i] = stack[i * lanes + lane];
+        interpreter.keyboard[i] = keyboard[i * lanes + lane] != 0x0;
+    }
+
+    interpreter.stack_pointer = stack_pointer[lane];
+    interpreter.sound_timer = sound_timer[lane];
+    interpreter.delay_timer = delay_timer[lane];
+    interpreter.index_register = index_register[lane];
+    interpreter.program_counter = program_counter[lane];
+    interpreter.stop_execution_flag = stop_execution_flag[lane];
+    interpreter.continue_execution_key = continue_execution_key[lane];
+    interpreter.random.restore(random[lane].state());
+    interpreter.unknown_opcodes = unknown_opcodes[lane];
+
+    if (interpreter.framebuffer != nullptr) {
+        interpreter.framebuffer->assign(*framebuffers[lane]);
+    }
+}
+
+uint8_t* BatchExecutor::row(std::vector<uint8_t> &rows, size_t index) {
+    return &rows[index * lanes];
+}
+
+BatchExecutor::Vector::Type BatchExecutor::load_row(std::vector<uint8_t> &rows, size_t index, size_t lane) {
+    return Vector::load(&rows[index * lanes + lane]);
+}
+
+// Fills group with the runnable lanes at the lowest program counter that fetch the same opcode
+// as the first of them; lanes whose own stores changed that opcode wait for a later step.
+// Returns false once every lane has used its budget or waits for a key.
+bool BatchExecutor::select(uint32_t budget, uint16_t &opcode) {
+    uint16_t target = 0xFFFF;
+    bool is_runnable = false;
+
+    for (size_t lane = 0; lane < instances; lane++) {
+        bool is_active = executed_count[lane] < budget && stop_execution_flag[lane] == 0x0;
+        group[lane] = is_active ? 0xFF : 0x00;
+        is_runnable |= is_active;
+        target = is_active ? std::min(target, program_counter[lane]) : target;
+    }
+
+    if (!is_runnable) {
+        return false;
+    }
+
+    size_t first = lanes;
+    for (size_t lane = 0; lane < instances; lane++) {
+        group[lane] &= program_counter[lane] == target ? 0xFF : 0x00;
+        first = group[lane] != 0x00 && first == lanes ? lane : first;
+    }
+
+    auto high_row = row(memory, target & ADDRESS_MASK);
+    auto low_row = row(memory, (target + 1) & ADDRESS_MASK);
+    auto high = Vector::broadcast(high_row[first]);
+    auto low = Vector::broadcast(low_row[first]);
+    opcode = high_row[first] << 8 | low_row[first];
+
+    for (size_t lane = 0; lane < lanes; lane += Vector::WIDTH) {
+        auto same = Vector::bit_and(Vector::equal(Vector::load(&high_row[lane]), high),
+                                    Vector::equal(Vector::load(&low_row[lane]), low));
+        Vector::store(&group[lane], Vector::bit_and(Vector::load(&group[lane]), same));
+    }
+
+    return true;
+}
+
+// Flags and results follow CommandExecutor exactly, including which write wins when x is F.
+void BatchExecutor::execute(uint16_t opcode) {
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+    uint16_t nnn = opcode & 0x0FFF;
+
+    auto kk_vector = Vector::broadcast(kk);
+    auto one = Vector::broadcast(0x1);
+    auto all = Vector::broadcast(0xFF);
+
+    auto instruction = decoder.decode(opcode);
+    if (instruction == nullptr) {
+        for (size_t lane = 0; lane < instances; lane++) {
+            unknown_opcodes[lane] += group[lane] & 0x1;
+        }
+        return;
+    }
+
+    switch (*instruction) {
+        case ::CLS:
+            for (size_t lane = 0; lane < instances; lane++) {
+                if (group[lane]) {
+                    framebuffers[lane]->clean();
+                }
+            }
+            advance();
+            break;
+        case ::RET:
+            for (size_t lane = 0; lane < instances; lane++) {
+                if (group[lane]) {
+                    auto level = --stack_pointer[lane] % STACK_SIZE;
+                    program_counter[lane] = stack[level * lanes + lane];
+                }
+            }
+            break;
+        case ::JP_ADDR:
+            jump(nnn);
+            break;
+        case ::CALL_ADDR:
+            for (size_t lane = 0; lane < instances; lane++) {
+                if (group[lane]) {
+                    auto level = stack_pointer[lane]++ % STACK_SIZE;
+                    stack[level * lanes + lane] = program_counter[lane] + 2;
+                }
+            }
+            jump(nnn);
+            break;
+        case ::SE_VX_BYTE:
+            skip([&](size_t lane) { return Vector::equal(load_row(registers, x, lane), kk_vector); });
+            break;
+        case ::SNE_VX_BYTE:
+            skip([&](size_t lane) {
+                return Vector::bit_xor(Vector::equal(load_row(registers, x, lane), kk_vector), all);
+            });
+            break;
+        case ::SE_VX_VY:
+            skip([&](size_t lane) {
+                return Vector::equal(load_row(registers, x, lane), load_row(registers, y, lane));
+            });
+            break;
+        case ::LD_VX_BYTE:
+            assign(row(registers, x), [&](size_t) { return kk_vector; });
+            advance();
+            break;
+        case ::ADD_VX_BYTE:
+            assign(row(registers, x), [&](size_t lane) { return Vector::add(load_row(registers, x, lane), kk_vector); });
+            advance();
+            break;
+        case ::LD_VX_VY:
+            assign(row(registers, x), [&](size_t lane) { return load_row(registers, y, lane); });
+            advance();
+            break;
+        case ::OR_VX_VY:
+            assign(row(registers, x), [&](size_t lane) {
+                return Vector::bit_or(load_row(registers, x, lane), load_row(registers, y, lane));
+            });
+            advance();
+            break;
+        case ::AND_VX_VY:
+            assign(row(registers, x), [&](size_t lane) {
+                return Vector::bit_and(load_row(registers, x, lane), load_row(registers, y, lane));
+            });
+            advance();
+            break;
+        case ::XOR_VX_VY:
+            assign(row(registers, x), [&](size_t lane) {
+                return Vector::bit_xor(load_row(registers, x, lane), load_row(registers, y, lane));
+            });
+            advance();
+            break;
+        case ::ADD_VX_VY_CARRY:
+            arithmetic(x, y,
+                       [&](Vector::Type vx, Vector::Type vy) {
+                           return Vector::bit_and(Vector::greater(vy, Vector::sub(all, vx)), one);
+                       },
+                       [&](Vector::Type, Vector::Type, Vector::Type rx, Vector::Type ry) { return Vector::add(rx, ry); });
+            break;
+        case ::SUB_VX_VY:
+            arithmetic(x, y,
+                       [&](Vector::Type vx, Vector::Type vy) { return Vector::bit_and(Vector::greater(vx, vy), one); },
+                       [&](Vector::Type, Vector::Type, Vector::Type rx, Vector::Type ry) { return Vector::sub(rx, ry); });
+            break;
+        case ::SHR_VX_VY:
+            arithmetic(x, y,
+                       [&](Vector::Type vx, Vector::Type) { return Vector::bit_and(vx, one); },
+                       [&](Vector::Type, Vector::Type, Vector::Type rx, Vector::Type) { return Vector::shift_right(rx); });
+            break;
+        case ::SUBN_VX_VY:
+            arithmetic(x, y,
+                       [&](Vector::Type vx, Vector::Type vy) { return Vector::bit_and(Vector::greater(vy, vx), one); },
+                       [&](Vector::Type vx, Vector::Type vy, Vector::Type, Vector::Type) { return Vector::sub(vy, vx); });
+            break;
+        case ::SHL_VX:
+            arithmetic(x, y,
+                       [&](Vector::Type vx, Vector::Type) { return Vector::top_bit(vx); },
+                       [&](Vector::Type, Vector::Type, Vector::Type rx, Vector::Type) { return Vector::add(rx, rx); });
+            break;
+        case ::SNE_VX_VY:
+            skip([&](size_t lane) {
+                return Vector::bit_xor(Vector::equal(load_row(registers, x, lane), load_row(registers, y, lane)), all);
+            });
+            break;
+        case ::LD_I_ADDR:
+            for (size_t lane = 0; lane < lanes; lane++) {
+                index_register[lane] = group[lane] ? nnn : index_register[lane];
+            }
+            advance();
+            break;
+        case ::JP_V0_ADDR:
+            for (size_t lane = 0; lane < lanes; lane++) {
+                program_counter[lane] = group[lane] ? nnn + registers[lane] : program_counter[lane];
+            }
+            break;
+        case ::RND_VX_BYTE:
+            for (size_t lane = 0; lane < instances; lane++) {
+                if (group[lane]) {
+                    registers[x * lanes + lane] = random[lane].next_byte() & kk;
+                }
+            }
+            advance();
+            break;
+        case ::DRW_VX_VY_N:
+            draw(x, y, n);
+            advance();
+            break;
+        case ::SKP_VX:
+        case ::SKPN_VX:
+            for (size_t lane = 0; lane < lanes; lane++) {
+                auto key = registers[x * lanes + lane] & 0xF;
+                condition[lane] = keyboard[key * lanes + lane] != 0x0 ? 0xFF : 0x00;
+            }
+            if (*instruction == ::SKPN_VX) {
+                skip([&](size_t lane) { return Vector::bit_xor(Vector::load(&condition[lane]), all); });
+            } else {
+                skip([&](size_t lane) { return Vector::load(&condition[lane]); });
+            }
+            break;
+        case ::LD_VX_DT:
+            assign(row(registers, x), [&](size_t lane) { return Vector::load(&delay_timer[lane]); });
+            advance();
+            break;
+        case ::LD_VX_K:
+            for (size_t lane = 0; lane < instances; lane++) {
+                if (group[lane]) {
+                    stop_execution_flag[lane] = 0x1;
+                    continue_execution_key[lane] = x;
+                }
+            }
+            advance();
+            break;
+        case ::LD_DT_VX:
+            assign(delay_timer.data(), [&](size_t lane) { return load_row(registers, x, lane); });
+            advance();
+            break;
+        case ::LD_ST_VX:
+            assign(sound_timer.data(), [&](size_t lane) { return load_row(registers, x, lane); });
+            advance();
+            break;
+        case ::ADD_I_VX:
+            for (size_t lane = 0; lane < lanes; lane++) {
+                if (group[lane]) {
+                    uint16_t sum = index_register[lane] + registers[x * lanes + lane];
+                    registers[0xF * lanes + lane] = sum > 0x0FFF ? 1 : 0;
+                    index_register[lane] = sum;
+                }
+            }
+            advance();
+            break;
+        case ::LD_F_VX:
+            for (size_t lane = 0; lane < lanes; lane++) {
+                index_register[lane] = group[lane] ? registers[x * lanes + lane] * 5 : index_register[lane];
+            }
+            advance();
+            break;
+        case ::LD_B_VX:
+            store_bcd(x);
+            advance();
+            break;
+        case ::LD_I_VX:
+            store_registers(x);
+            advance();
+            break;
+        case ::LD_VX_I:
+            load_registers(x);
+            advance();
+            break;
+    }
+}
+
+// Stores operation(lane) into target for the lanes in group, a LaneVector at a time.
+template <typename Operation>
+void BatchExecutor::assign(uint8_t *target, Operation operation) {
+    for (size_t lane = 0; lane < lanes; lane += Vector::WIDTH) {
+        auto mask = Vector::load(&group[lane]);
+        Vector::store(&target[lane], Vector::select(mask, operation(lane), Vector::load(&target[lane])));
+    }
+}
+
+// Writes VF from the original Vx and Vy, then Vx. The result sees VF's new value when x or y
+// is F, as the scalar handlers do by reading the registers again.
+template <typename Flag, typename Operation>
+void BatchExecutor::arithmetic(uint8_t x, uint8_t y, Flag flag, Operation operation) {
+    auto vx_row = row(registers, x);
+    auto vy_row = row(registers, y);
+    auto vf_row = row(registers, 0xF);
+
+    for (size_t lane = 0; lane < lanes; lane += Vector::WIDTH) {
+        auto mask = Vector::load(&group[lane]);
+        auto vx = Vector::load(&vx_row[lane]);
+        auto vy = Vector::load(&vy_row[lane]);
+
+        Vector::store(&vf_row[lane], Vector::select(mask, flag(vx, vy), Vector::load(&vf_row[lane])));
+
+        auto rx = Vector::load(&vx_row[lane]);
+        auto ry = Vector::load(&vy_row[lane]);
+        Vector::store(&vx_row[lane], Vector::select(mask, operation(vx, vy, rx, ry), rx));
+    }
+
+    advance();
+}
+
+// Steps over the next instruction in the lanes where condition_operation(lane) is set.
+template <typename Condition>
+void BatchExecutor::skip(Condition condition_operation) {
+    for (size_t lane = 0; lane < lanes; lane += Vector::WIDTH) {
+        Vector::store(&condition[lane], condition_operation(lane));
+    }
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        program_counter[lane] += group[lane] & (0x2 + (condition[lane] & 0x2));
+    }
+}
+
+void BatchExecutor::advance() {
+    for (size_t lane = 0; lane < lanes; lane++) {
+        program_counter[lane] += group[lane] & 0x2;
+    }
+}
+
+void BatchExecutor::jump(uint16_t address) {
+    for (size_t lane = 0; lane < lanes; lane++) {
+        program_counter[lane] = group[lane] ? address : program_counter[lane];
+    }
+}
+
+// Sprites are gathered out of the lane's memory column first; addresses wrap at 4 KiB.
+void BatchExecutor::draw(uint8_t x, uint8_t y, uint8_t n) {
+    uint8_t sprite[16];
+
+    for (size_t lane = 0; lane < instances; lane++) {
+        if (!group[lane]) {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < n; i++) {
+            sprite[i] = memory[((index_register[lane] + i) & ADDRESS_MASK) * lanes + lane];
+        }
+
+        uint8_t vx = registers[x * lanes + lane];
+        uint8_t vy = registers[y * lanes + lane];
+        registers[0xF * lanes + lane] = framebuffers[lane]->draw(sprite, n, vx, vy);
+    }
+}
+
+void BatchExecutor::store_bcd(uint8_t x) {
+    for (size_t lane = 0; lane < instances; lane++) {
+        if (!group[lane]) {
+            continue;
+        }
+
+        uint8_t vx = registers[x * lanes + lane];
+        uint16_t index = index_register[lane];
+        memory[(index & ADDRESS_MASK) * lanes + lane] = vx / 100;
+        memory[((index + 1) & ADDRESS_MASK) * lanes + lane] = (vx / 10) % 10;
+        memory[((index + 2) & ADDRESS_MASK) * lanes + lane] = (vx % 100) % 10;
+    }
+}
+
+void BatchExecutor::store_registers(uint8_t x) {
+    for (size_t lane = 0; lane < instances; lane++) {
+        if (!group[lane]) {
+            continue;
+        }
+
+        for (uint8_t i = 0; i <= x; i++) {
+            memory[((index_register[lane] + i) & ADDRESS_MASK) * lanes + lane] = registers[i * lanes + lane];
+        }
+        index_register[lane] += x + 1;
+    }
+}
+
+void BatchExecutor::load_registers(uint8_t x) {
+    for (size_t lane = 0; lane < instances; lane++) {
+        if (!group[lane]) {
+            continue;
+        }
+
+        for (uint8_t i = 0; i <= x; i++) {
+            registers[i * lanes + lane] = memory[((index_register[lane] + i) & ADDRESS_MASK) * lanes + lane];
+        }
+        index_register[lane] += x + 1;
+    }
+}
@@ -1,219 +1,335 @@
 #include <memory>
 #include <istream>
+#include <iostream>
+#include <cstring>
+#include <chrono>
 #include "base_interpreter.hpp"
+#include "framebuffer.hpp"
 #include "instruction.hpp"
+#include "decoder.hpp"
 #include "functions.hpp"
+#include "opcode_stats.hpp"
+
+#pragma once
 
 class CommandExecutor {
 private:
+    struct MicroOp;
+
+    typedef void (CommandExecutor::*Handler)(const MicroOp &op);
+    typedef std::array<Handler, Decoder::TABLE_SIZE> DispatchTable;
+
+    // An opcode with its handler resolved and operand fields pre-extracted.
+    struct MicroOp {
+        Handler handler;
+        uint16_t opcode;
+        uint16_t nnn;
+        uint8_t x;
+        uint8_t y;
+        uint8_t n;
+        uint8_t kk;
+    };
+
+    static const uint16_t ADDRESS_MASK = 0x0FFF;
+
     BaseInterpreter *interpreter_ptr;
+    const DispatchTable &handlers;
+
+    // Decoded micro-ops keyed by program counter. Entries start out (and are reset to) predecode,
+    // which decodes the opcode at the current address in place and then runs it.
+    std::array<MicroOp, 4096> cache;
 
     static const uint16_t NEXT_PC = 2;
     static const uint16_t SKIP_PC = 4;
 
-    void cls();
-    void ret();
-    void jp_addr(uint16_t opcode);
-    void call_addr(uint16_t opcode);
-    void se_vx_byte(uint16_t opcode);
-    void sne_vx_byte(uint16_t opcode);
-    void se_vx_vy(uint16_t opcode);
-    void ld_vx_byte(uint16_t opcode);
-    void add_byte(uint16_t opcode);
-    void ld_vx_vy(uint16_t opcode);
-    void or_vx_vy(uint16_t opcode);
-    void add_VX_VY(uint16_t opcode);
-    void xor_vx_vy(uint16_t opcode);
-    void add_vx_vy_carry(uint16_t opcode);
-    void sub_vx_vy(uint16_t opcode);
-    void shr_vx_vy(uint16_t opcode);
-    void subn_vx_vy(uint16_t opcode);
-    void shl_vx(uint16_t opcode);
-    void sne_vx_vy(uint16_t opcode);
-    void ld_i_addr(uint16_t opcode);
-    void jp_v0_addr(uint16_t opcode);
-    void rnd_vy_byte(uint16_t opcode);
-    void drw_vy_vy_n(uint16_t opcode);
-    void skp_vx(uint16_t opcode);
-    void skpn_vx(uint16_t opcode);
-    void ld_vx_dt(uint16_t opcode);
-    void ld_vx_k(uint16_t opcode);
-    void ld_dt_vx(uint16_t opcode);
-    void ld_st_vx(uint16_t opcode);
-    void add_i_vx(uint16_t opcode);
-    void ld_f_vx(uint16_t opcode);
-    void ld_b_vx(uint16_t opcode);
-    void ld_i_vx(uint16_t opcode);
-    void ld_vx_i(uint16_t opcode);
+    static const DispatchTable& dispatch_table();
+    static Handler handler(const Instruction *instruction);
+
+    MicroOp micro_op(uint16_t opcode) const;
+    void predecode(const MicroOp &op);
+
+#ifdef CHIP8_OPCODE_STATS
+    // Null unless counting was switched on at runtime.
+    OpcodeStats *stats_ptr = nullptr;
+
+    void measure(const MicroOp &op, uint16_t opcode);
+#endif
+
+    void unknown(const MicroOp &op);
+    void cls(const MicroOp &op);
+    void ret(const MicroOp &op);
+    void jp_addr(const MicroOp &op);
+    void call_addr(const MicroOp &op);
+    void se_vx_byte(const MicroOp &op);
+    void sne_vx_byte(const MicroOp &op);
+    void se_vx_vy(const MicroOp &op);
+    void ld_vx_byte(const MicroOp &op);
+    void add_byte(const MicroOp &op);
+    void ld_vx_vy(const MicroOp &op);
+    void or_vx_vy(const MicroOp &op);
+    void add_VX_VY(const MicroOp &op);
+    void xor_vx_vy(const MicroOp &op);
+    void add_vx_vy_carry(const MicroOp &op);
+    void sub_vx_vy(const MicroOp &op);
+    void shr_vx_vy(const MicroOp &op);
+    void subn_vx_vy(const MicroOp &op);
+    void shl_vx(const MicroOp &op);
+    void sne_vx_vy(const MicroOp &op);
+    void ld_i_addr(const MicroOp &op);
+    void jp_v0_addr(const MicroOp &op);
+    void rnd_vy_byte(const MicroOp &op);
+    void drw_vy_vy_n(const MicroOp &op);
+    void skp_vx(const MicroOp &op);
+    void skpn_vx(const MicroOp &op);
+    void ld_vx_dt(const MicroOp &op);
+    void ld_vx_k(const MicroOp &op);
+    void ld_dt_vx(const MicroOp &op);
+    void ld_st_vx(const MicroOp &op);
+    void add_i_vx(const MicroOp &op);
+    void ld_f_vx(const MicroOp &op);
+    void ld_b_vx(const MicroOp &op);
+    void ld_i_vx(const MicroOp &op);
+    void ld_vx_i(const MicroOp &op);
 public:
     CommandExecutor(BaseInterpreter *interpreter);
 
-    void execute(const Instruction *instruction, uint16_t opcode);
+    void step();
+    void execute(uint16_t opcode);
+    void invalidate(uint16_t address, uint16_t length);
+#ifdef CHIP8_OPCODE_STATS
+    void set_stats(OpcodeStats *stats);
+#endif
 };
 
-CommandExecutor::CommandExecutor(BaseInterpreter *interpreter) : interpreter_ptr(interpreter) {
+CommandExecutor::CommandExecutor(BaseInterpreter *interpreter) : interpreter_ptr(interpreter), handlers(dispatch_table()) {
+    invalidate(0, cache.size());
 }
 
-void CommandExecutor::execute(const Instruction *instruction, uint16_t opcode) {
-    if (instruction == nullptr) {
-        std::cout << "Unknown opcode " << to_hex(opcode) << std::endl;
+void CommandExecutor::step() {
+    auto &op = cache[interpreter_ptr->program_counter & ADDRESS_MASK];
+#ifdef CHIP8_OPCODE_STATS
+    if (stats_ptr != nullptr) {
+        auto pc = interpreter_ptr->program_counter & ADDRESS_MASK;
+        measure(op, interpreter_ptr->memory[pc] << 8 | interpreter_ptr->memory[(pc + 1) & ADDRESS_MASK]);
+        return;
+    }
+#endif
+    (this->*op.handler)(op);
+}
+
+void CommandExecutor::execute(uint16_t opcode) {
+    auto op = micro_op(opcode);
+#ifdef CHIP8_OPCODE_STATS
+    if (stats_ptr != nullptr) {
+        measure(op, opcode);
         return;
     }
+#endif
+    (this->*op.handler)(op);
+}
+
+// Drops cached micro-ops overlapping [address, address + length), including the one starting a byte earlier.
+void CommandExecutor::invalidate(uint16_t address, uint16_t length) {
+    MicroOp op = {&CommandExecutor::predecode, 0, 0, 0, 0, 0, 0};
+
+    for (uint32_t i = 0; i <= length; i++) {
+        cache[(address + i - 1) & ADDRESS_MASK] = op;
+    }
+}
+
+#ifdef CHIP8_OPCODE_STATS
+void CommandExecutor::set_stats(OpcodeStats *stats) {
+    stats_ptr = stats;
+}
+
+// The opcode comes from memory rather than op, which may still be predecode. The timed span
+// covers the handler alone, including whatever a draw does synchronously in the render.
+void CommandExecutor::measure(const MicroOp &op, uint16_t opcode) {
+    auto index = OpcodeStats::index(Decoder::instance().decode(opcode));
+
+    if (!stats_ptr->count(index)) {
+        (this->*op.handler)(op);
+        return;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    (this->*op.handler)(op);
+    auto end = std::chrono::steady_clock::now();
+
+    stats_ptr->sample(index, std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+}
+#endif
+
+CommandExecutor::MicroOp CommandExecutor::micro_op(uint16_t opcode) const {
+    return {
+        handlers[opcode],
+        opcode,
+        static_cast<uint16_t>(opcode & 0x0FFF),
+        static_cast<uint8_t>((opcode & 0x0F00) >> 8),
+        static_cast<uint8_t>((opcode & 0x00F0) >> 4),
+        static_cast<uint8_t>(opcode & 0x000F),
+        static_cast<uint8_t>(opcode & 0x00FF)
+    };
+}
+
+void CommandExecutor::predecode(const MicroOp &) {
+    auto pc = interpreter_ptr->program_counter & ADDRESS_MASK;
+    auto opcode = interpreter_ptr->memory[pc] << 8 | interpreter_ptr->memory[(pc + 1) & ADDRESS_MASK];
+
+    cache[pc] = micro_op(opcode);
+    (this->*cache[pc].handler)(cache[pc]);
+}
+
+const CommandExecutor::DispatchTable& CommandExecutor::dispatch_table() {
+    static const auto table = [] {
+        auto table = std::make_unique<DispatchTable>();
+        auto &decoder = Decoder::instance();
+
+        for (size_t opcode = 0; opcode < Decoder::TABLE_SIZE; opcode++) {
+            (*table)[opcode] = handler(decoder.decode(opcode));
+        }
+
+        return table;
+    }();
+
+    return *table;
+}
+
+CommandExecutor::Handler CommandExecutor::handler(const Instruction *instruction) {
+    if (instruction == nullptr) {
+        return &CommandExecutor::unknown;
+    }
 
     switch (*instruction) {
         case ::CLS:
-            cls();
-            break;
+            return &CommandExecutor::cls;
         case ::RET:
-            ret();
-            break;
+            return &CommandExecutor::ret;
         case ::JP_ADDR:
-            jp_addr(opcode);
-            break;
+            return &CommandExecutor::jp_addr;
         case ::CALL_ADDR:
-            call_addr(opcode);
-            break;
+            return &CommandExecutor::call_addr;
         case ::SE_VX_BYTE:
-            se_vx_byte(opcode);
-            break;
+            return &CommandExecutor::se_vx_byte;
         case ::SNE_VX_BYTE:
-            sne_vx_byte(opcode);
-            break;
+            return &CommandExecutor::sne_vx_byte;
         case ::SE_VX_VY:
-            se_vx_vy(opcode);
-            break;
+            return &CommandExecutor::se_vx_vy;
         case ::LD_VX_BYTE:
-            ld_vx_byte(opcode);
-            break;
+            return &CommandExecutor::ld_vx_byte;
         case ::ADD_VX_BYTE:
-            add_byte(opcode);
-            break;
+            return &CommandExecutor::add_byte;
         case ::LD_VX_VY:
-            ld_vx_vy(opcode);
-            break;
+            return &CommandExecutor::ld_vx_vy;
         case ::OR_VX_VY:
-            or_vx_vy(opcode);
-            break;
+            return &CommandExecutor::or_vx_vy;
         case ::AND_VX_VY:
-            add_VX_VY(opcode);
-            break;
+            return &CommandExecutor::add_VX_VY;
         case ::XOR_VX_VY:
-            xor_vx_vy(opcode);
-            break;
+            return &CommandExecutor::xor_vx_vy;
         case ::ADD_VX_VY_CARRY:
-            add_vx_vy_carry(opcode);
-            break;
+            return &CommandExecutor::add_vx_vy_carry;
         case ::SUB_VX_VY:
-            sub_vx_vy(opcode);
-            break;
+            return &CommandExecutor::sub_vx_vy;
         case ::SHR_VX_VY:
-            shr_vx_vy(opcode);
-            break;
+            return &CommandExecutor::shr_vx_vy;
         case ::SUBN_VX_VY:
-            subn_vx_vy(opcode);
-            break;
+            return &CommandExecutor::subn_vx_vy;
         case ::SHL_VX:
-            shl_vx(opcode);
-            break;
+            return &CommandExecutor::shl_vx;
         case ::SNE_VX_VY:
-            sne_vx_vy(opcode);
-            break;
+            return &CommandExecutor::sne_vx_vy;
         case ::LD_I_ADDR:
-            ld_i_addr(opcode);
-            break;
+            return &CommandExecutor::ld_i_addr;
         case ::JP_V0_ADDR:
-            jp_v0_addr(opcode);
-            break;
+            return &CommandExecutor::jp_v0_addr;
         case ::RND_VX_BYTE:
-            rnd_vy_byte(opcode);
-            break;
+            return &CommandExecutor::rnd_vy_byte;
         case ::DRW_VX_VY_N:
-            drw_vy_vy_n(opcode);
-            break;
+            return &CommandExecutor::drw_vy_vy_n;
         case ::SKP_VX:
-            skp_vx(opcode);
-            break;
+            return &CommandExecutor::skp_vx;
         case ::SKPN_VX:
-            skpn_vx(opcode);
-            break;
+            return &CommandExecutor::skpn_vx;
         case ::LD_VX_DT:
-            ld_vx_dt(opcode);
-            break;
+            return &CommandExecutor::ld_vx_dt;
         case ::LD_VX_K:
-            ld_vx_k(opcode);
-            break;
+            return &CommandExecutor::ld_vx_k;
         case ::LD_DT_VX:
-            ld_dt_vx(opcode);
-            break;
+            return &CommandExecutor::ld_dt_vx;
         case ::LD_ST_VX:
-            ld_st_vx(opcode);
-            break;
+            return &CommandExecutor::ld_st_vx;
         case ::ADD_I_VX:
-            add_i_vx(opcode);
-            break;
+            return &CommandExecutor::add_i_vx;
         case ::LD_F_VX:
-            ld_f_vx(opcode);
-            break;
+            return &CommandExecutor::ld_f_vx;
         case ::LD_B_VX:
-            ld_b_vx(opcode);
-            break;
+            return &CommandExecutor::ld_b_vx;
         case ::LD_I_VX:
-            ld_i_vx(opcode);
-            break;
+            return &CommandExecutor::ld_i_vx;
         case ::LD_VX_I:
-            ld_vx_i(opcode);
-            break;
+            return &CommandExecutor::ld_vx_i;
+    }
+
+    return &CommandExecutor::unknown;
+}
+
+void CommandExecutor::unknown(const MicroOp &op) {
+    interpreter_ptr->unknown_opcodes++;
+
+    if (interpreter_ptr->log != nullptr) {
+        *interpreter_ptr->log << "Unknown opcode " << to_hex(op.opcode) << std::endl;
     }
 }
 
 // 0x00E0
-void CommandExecutor::cls() {
+void CommandExecutor::cls(const MicroOp &) {
     interpreter_ptr->framebuffer->clean();
     interpreter_ptr->program_counter += 2;
 }
 
 // 0x00EE
-void CommandExecutor::ret() {
+void CommandExecutor::ret(const MicroOp &) {
     interpreter_ptr->program_counter = interpreter_ptr->stack[--interpreter_ptr->stack_pointer];
 }
 
 // 0x1nnn
-void CommandExecutor::jp_addr(uint16_t opcode) {
-    uint16_t nnn = opcode & 0x0FFF;
+void CommandExecutor::jp_addr(const MicroOp &op) {
+    uint16_t nnn = op.nnn;
 
     interpreter_ptr->program_counter = nnn;
 }
 
 // 0x2nnn
-void CommandExecutor::call_addr(uint16_t opcode) {
-    uint16_t nnn = opcode & 0x0FFF;
+void CommandExecutor::call_addr(const MicroOp &op) {
+    uint16_t nnn = op.nnn;
 
     interpreter_ptr->stack[interpreter_ptr->stack_pointer++] = interpreter_ptr->program_counter + 2;
     interpreter_ptr->program_counter = nnn;
 }
 
 // 0x3xkk
-void CommandExecutor::se_vx_byte(uint16_t opcode) {
-    uint8_t k = (opcode & 0x0F00) >> 8;
-    uint8_t kk = opcode & 0x00FF;
+void CommandExecutor::se_vx_byte(const MicroOp &op) {
+    uint8_t k = op.x;
+    uint8_t kk = op.kk;
 
     uint16_t pointer = interpreter_ptr->registers[k] == kk ? 4 : 2;
     interpreter_ptr->program_counter += pointer;
 }
 
 // 0x4xkk
-void CommandExecutor::sne_vx_byte(uint16_t opcode) {
-    uint8_t k = (opcode & 0x0F00) >> 8;
-    uint8_t kk = opcode & 0x00FF;
+void CommandExecutor::sne_vx_byte(const MicroOp &op) {
+    uint8_t k = op.x;
+    uint8_t kk = op.kk;
 
     uint16_t pointer = interpreter_ptr->registers[k] != kk ? 4 : 2;
     interpreter_ptr->program_counter += pointer;
 }
 
 // 0x5xy0
-void CommandExecutor::se_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::se_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
 
@@ -222,63 +338,63 @@ void CommandExecutor::se_vx_vy(uint16_t opcode) {
 }
 
 // 0x6xkk
-void CommandExecutor::ld_vx_byte(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t kk = opcode & 0x00FF;
+void CommandExecutor::ld_vx_byte(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t kk = op.kk;
 
     interpreter_ptr->registers[x] = kk;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x7xkk
-void CommandExecutor::add_byte(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t kk = opcode & 0x00FF;
+void CommandExecutor::add_byte(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t kk = op.kk;
 
     interpreter_ptr->registers[x] += kk;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x8xy0
-void CommandExecutor::ld_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::ld_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
 
     interpreter_ptr->registers[x] = interpreter_ptr->registers[y];
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x8xy1
-void CommandExecutor::or_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::or_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
 
     interpreter_ptr->registers[x] |= interpreter_ptr->registers[y];
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x8xy2
-void CommandExecutor::add_VX_VY(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::add_VX_VY(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
 
     interpreter_ptr->registers[x] &= interpreter_ptr->registers[y];
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x8xy3
-void CommandExecutor::xor_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::xor_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
 
     interpreter_ptr->registers[x] ^= interpreter_ptr->registers[y];
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0x8xy4
-void CommandExecutor::add_vx_vy_carry(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::add_vx_vy_carry(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
 
@@ -288,9 +404,9 @@ void CommandExecutor::add_vx_vy_carry(uint16_t opcode) {
 }
 
 // 0x8xy5
-void CommandExecutor::sub_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::sub_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
 
@@ -300,8 +416,8 @@ void CommandExecutor::sub_vx_vy(uint16_t opcode) {
 }
 
 // 0x8xy6
-void CommandExecutor::shr_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::shr_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
 
     interpreter_ptr->registers[0xF] = interpreter_ptr->registers[x] & 0x1;
     interpreter_ptr->registers[x] >>= 1;
@@ -309,9 +425,9 @@ void CommandExecutor::shr_vx_vy(uint16_t opcode) {
 }
 
 // 0x8xy7
-void CommandExecutor::subn_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::subn_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
 
@@ -321,8 +437,8 @@ void CommandExecutor::subn_vx_vy(uint16_t opcode) {
 }
 
 // 0x8xyE
-void CommandExecutor::shl_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::shl_vx(const MicroOp &op) {
+    uint8_t x = op.x;
 
     interpreter_ptr->registers[0xF] = interpreter_ptr->registers[x] >> 7;
     interpreter_ptr->registers[x] <<= 1;
@@ -330,9 +446,9 @@ void CommandExecutor::shl_vx(uint16_t opcode) {
 }
 
 // 0x9xy0
-void CommandExecutor::sne_vx_vy(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::sne_vx_vy(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
 
@@ -341,38 +457,38 @@ void CommandExecutor::sne_vx_vy(uint16_t opcode) {
 }
 
 // 0xAnnn
-void  CommandExecutor::ld_i_addr(uint16_t opcode) {
-    uint16_t nnn = opcode & 0x0FFF;
+void  CommandExecutor::ld_i_addr(const MicroOp &op) {
+    uint16_t nnn = op.nnn;
 
     interpreter_ptr->index_register = nnn;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xBnnn
-void CommandExecutor::jp_v0_addr(uint16_t opcode) {
-    uint16_t nnn = opcode & 0x0FFF;
+void CommandExecutor::jp_v0_addr(const MicroOp &op) {
+    uint16_t nnn = op.nnn;
     uint8_t vx = interpreter_ptr->registers[0x0];
 
     interpreter_ptr->program_counter = nnn + vx;
 }
 
 // 0xCxkk
-void CommandExecutor::rnd_vy_byte(uint16_t opcode) {
-    uint8_t k = (opcode & 0x0F00) >> 8;
-    uint8_t kk = opcode & 0x00FF;
-    uint8_t rnd = rand() % 256;
+void CommandExecutor::rnd_vy_byte(const MicroOp &op) {
+    uint8_t k = op.x;
+    uint8_t kk = op.kk;
+    uint8_t rnd = interpreter_ptr->random.next_byte();
 
     interpreter_ptr->registers[k] = rnd & kk;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xDxyn
-void CommandExecutor::drw_vy_vy_n(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+void CommandExecutor::drw_vy_vy_n(const MicroOp &op) {
+    uint8_t x = op.x;
+    uint8_t y = op.y;
     uint8_t vx = interpreter_ptr->registers[x];
     uint8_t vy = interpreter_ptr->registers[y];
-    uint8_t len = opcode & 0x000F;
+    uint8_t len = op.n;
     auto memory = &interpreter_ptr->memory[interpreter_ptr->index_register];
 
     interpreter_ptr->registers[0xF] = interpreter_ptr->framebuffer->draw(memory, len, vx, vy);
@@ -380,44 +496,41 @@ void CommandExecutor::drw_vy_vy_n(uint16_t opcode) {
 }
 
 // 0xEx9E
-void CommandExecutor::skp_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::skp_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
 
-    uint16_t pointer = interpreter_ptr->keyboard[vx] ? SKIP_PC : NEXT_PC;
+    uint16_t pointer = interpreter_ptr->keyboard[vx & 0xF] ? SKIP_PC : NEXT_PC;
     interpreter_ptr->program_counter += pointer;
 }
 
 // 0xExA1
-void CommandExecutor::skpn_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::skpn_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
 
-    uint16_t pointer = !interpreter_ptr->keyboard[vx] ? SKIP_PC : NEXT_PC;
+    uint16_t pointer = !interpreter_ptr->keyboard[vx & 0xF] ? SKIP_PC : NEXT_PC;
     interpreter_ptr->program_counter += pointer;
 }
 
 // 0xFx07
-void CommandExecutor::ld_vx_dt(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_vx_dt(const MicroOp &op) {
+    uint8_t x = op.x;
 
     interpreter_ptr->registers[x] = interpreter_ptr->delay_timer;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
-// 0xFx0A
-void CommandExecutor::ld_vx_k(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t vx = interpreter_ptr->registers[x];
-
+// 0xFx0A; the key pressed next goes to Vx, so x is what has to be remembered.
+void CommandExecutor::ld_vx_k(const MicroOp &op) {
     interpreter_ptr->stop_execution_flag = 0x1;
-    interpreter_ptr->continue_execution_key = vx;
+    interpreter_ptr->continue_execution_key = op.x;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xFx15
-void CommandExecutor::ld_dt_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_dt_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
 
     interpreter_ptr->delay_timer = vx;
@@ -425,8 +538,8 @@ void CommandExecutor::ld_dt_vx(uint16_t opcode) {
 }
 
 // 0xFx18
-void CommandExecutor::ld_st_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_st_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
 
     interpreter_ptr->sound_timer = vx;
@@ -434,8 +547,8 @@ void CommandExecutor::ld_st_vx(uint16_t opcode) {
 }
 
 // 0xFx1E
-void CommandExecutor::add_i_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::add_i_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
 
     interpreter_ptr->registers[0xF] = interpreter_ptr->index_register + vx > 0x0FFF ? 1 : 0;
@@ -444,42 +557,44 @@ void CommandExecutor::add_i_vx(uint16_t opcode) {
 }
 
 // 0xFx29
-void CommandExecutor::ld_f_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_f_vx(const MicroOp &op) {
+    uint8_t x = op.x;
 
     interpreter_ptr->index_register = interpreter_ptr->registers[x] * 5;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xFx33
-void CommandExecutor::ld_b_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_b_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint8_t vx = interpreter_ptr->registers[x];
     uint16_t index = interpreter_ptr->index_register;
 
     interpreter_ptr->memory[index] = vx / 100;
     interpreter_ptr->memory[index + 1] = (vx / 10) % 10;
     interpreter_ptr->memory[index + 2] = (vx % 100) % 10;
+    invalidate(index, 3);
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xFx55
-void CommandExecutor::ld_i_vx(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_i_vx(const MicroOp &op) {
+    uint8_t x = op.x;
     uint16_t index = interpreter_ptr->index_register;
 
-    std::memcpy(&interpreter_ptr->registers[index], &interpreter_ptr->memory[index], x);
+    std::memcpy(&interpreter_ptr->memory[index], &interpreter_ptr->registers[0], x + 1);
+    invalidate(index, x + 1);
 
     interpreter_ptr->index_register += x + 1;
     interpreter_ptr->program_counter += NEXT_PC;
 }
 
 // 0xFx65
-void CommandExecutor::ld_vx_i(uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
+void CommandExecutor::ld_vx_i(const MicroOp &op) {
+    uint8_t x = op.x;
     uint16_t index = interpreter_ptr->index_register;
 
-    std::memcpy(&interpreter_ptr->memory[index], &interpreter_ptr->registers[index], x);
+    std::memcpy(&interpreter_ptr->registers[0], &interpreter_ptr->memory[index], x + 1);
 
     interpreter_ptr->index_register += x + 1;
     interpreter_ptr->program_counter += NEXT_PC;
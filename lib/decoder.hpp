@@ -0,0 +1,35 @@
+#include <array>
+#include "instruction.hpp"
+
+#pragma once
+
+// Maps every raw opcode straight to its instruction, so decoding is one indexed load.
+// The table is filled once from find_instruction; unknown opcodes map to nullptr.
+class Decoder {
+public:
+    static const size_t TABLE_SIZE = 0x10000;
+
+    static const Decoder& instance();
+
+    const Instruction* decode(uint16_t opcode) const;
+
+private:
+    std::array<const Instruction*, TABLE_SIZE> table;
+
+    Decoder();
+};
+
+Decoder::Decoder() {
+    for (size_t opcode = 0; opcode < TABLE_SIZE; opcode++) {
+        table[opcode] = find_instruction(opcode);
+    }
+}
+
+const Decoder& Decoder::instance() {
+    static const Decoder decoder;
+    return decoder;
+}
+
+const Instruction* Decoder::decode(uint16_t opcode) const {
+    return table[opcode];
+}
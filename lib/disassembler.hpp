@@ -0,0 +1,189 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "instruction.hpp"
+#include "decoder.hpp"
+
+#pragma once
+
+// Turns opcodes into mnemonics like `LD V3, 0x2A` or `DRW V0, V1, 5`, following the syntax
+// templates in instruction_table: %x and %y are registers, %k a byte, %n a nibble, %m an address,
+// and %a a JP or CALL target, which prints as a label when one was added for it.
+// Lines are written into buffers the caller provides, at most LINE_SIZE bytes with the
+// terminator, so formatting never allocates.
+class Disassembler {
+public:
+    static const size_t LINE_SIZE = 32;
+
+    enum Label : uint8_t {
+        NONE,
+        JUMP,
+        CALL
+    };
+
+    Disassembler();
+
+    void add_label(uint16_t address, Label label);
+    void add_target(uint16_t opcode);
+    void find_labels(const uint8_t *code, uint16_t begin, uint16_t end);
+    void clear_labels();
+    Label label(uint16_t address) const;
+
+    size_t format(uint16_t opcode, char *out) const;
+    size_t format_label(uint16_t address, char *out) const;
+    size_t format_line(uint16_t address, uint16_t opcode, char *out) const;
+
+private:
+    const Decoder &decoder = Decoder::instance();
+    std::array<Label, 4096> labels;
+
+    static char* put_hex(char *out, uint32_t value, size_t digits);
+    char* put_address(char *out, uint16_t address) const;
+};
+
+Disassembler::Disassembler() {
+    clear_labels();
+}
+
+void Disassembler::add_label(uint16_t address, Label label) {
+    auto &current = labels[address & 0x0FFF];
+    if (label > current) {
+        current = label;
+    }
+}
+
+// Labels the target of a JP or CALL opcode; other opcodes are ignored.
+void Disassembler::add_target(uint16_t opcode) {
+    auto instruction = decoder.decode(opcode);
+
+    if (instruction != nullptr && *instruction == ::JP_ADDR) {
+        add_label(opcode & 0x0FFF, JUMP);
+    } else if (instruction != nullptr && *instruction == ::CALL_ADDR) {
+        add_label(opcode & 0x0FFF, CALL);
+    }
+}
+
+// Sweeps the opcodes of code, which holds the bytes from begin to end, for jump and call targets.
+void Disassembler::find_labels(const uint8_t *code, uint16_t begin, uint16_t end) {
+    for (uint32_t address = begin; address + 1 < end; address += 2) {
+        add_target(code[address - begin] << 8 | code[address - begin + 1]);
+    }
+}
+
+void Disassembler::clear_labels() {
+    labels.fill(NONE);
+}
+
+Disassembler::Label Disassembler::label(uint16_t address) const {
+    return labels[address & 0x0FFF];
+}
+
+// Writes the mnemonic of opcode and returns its length.
+size_t Disassembler::format(uint16_t opcode, char *out) const {
+    auto instruction = decoder.decode(opcode);
+    auto text = instruction == nullptr ? "DW %w" : instruction_info(instruction).syntax;
+    auto begin = out;
+
+    for (; *text != '\0'; text++) {
+        if (*text != '%') {
+            *out++ = *text;
+            continue;
+        }
+
+        switch (*++text) {
+            case 'x':
+                *out++ = 'V';
+                out = put_hex(out, (opcode >> 8) & 0xF, 1);
+                break;
+            case 'y':
+                *out++ = 'V';
+                out = put_hex(out, (opcode >> 4) & 0xF, 1);
+                break;
+            case 'k':
+                *out++ = '0';
+                *out++ = 'x';
+                out = put_hex(out, opcode & 0xFF, 2);
+                break;
+            case 'n': {
+                auto n = opcode & 0xF;
+                if (n >= 10) {
+                    *out++ = '1';
+                }
+                *out++ = '0' + n % 10;
+                break;
+            }
+            case 'a':
+                out = put_address(out, opcode & 0x0FFF);
+                break;
+            case 'm':
+                *out++ = '0';
+                *out++ = 'x';
+                out = put_hex(out, opcode & 0x0FFF, 3);
+                break;
+            case 'w':
+                *out++ = '0';
+                *out++ = 'x';
+                out = put_hex(out, opcode, 4);
+                break;
+        }
+    }
+
+    *out = '\0';
+    return out - begin;
+}
+
+// Writes the label name for address, sub_2A4 for subroutines and loc_2A4 for jump targets;
+// returns 0 and writes nothing else when address has no label.
+size_t Disassembler::format_label(uint16_t address, char *out) const {
+    auto label = labels[address & 0x0FFF];
+    if (label == NONE) {
+        *out = '\0';
+        return 0;
+    }
+
+    const char *prefix = label == CALL ? "sub_" : "loc_";
+    auto begin = out;
+    while (*prefix != '\0') {
+        *out++ = *prefix++;
+    }
+    out = put_hex(out, address & 0x0FFF, 3);
+
+    *out = '\0';
+    return out - begin;
+}
+
+// Address, raw opcode and mnemonic, as in `0204  F107  LD V1, DT`.
+size_t Disassembler::format_line(uint16_t address, uint16_t opcode, char *out) const {
+    auto begin = out;
+
+    out = put_hex(out, address, 4);
+    *out++ = ' ';
+    *out++ = ' ';
+    out = put_hex(out, opcode, 4);
+    *out++ = ' ';
+    *out++ = ' ';
+
+    return out - begin + format(opcode, out);
+}
+
+// Uppercase, zero padded to digits.
+char* Disassembler::put_hex(char *out, uint32_t value, size_t digits) {
+    static const char HEX[] = "0123456789ABCDEF";
+
+    for (size_t i = digits; i > 0; i--) {
+        out[i - 1] = HEX[value & 0xF];
+        value >>= 4;
+    }
+
+    return out + digits;
+}
+
+char* Disassembler::put_address(char *out, uint16_t address) const {
+    if (labels[address] != NONE) {
+        return out + format_label(address, out);
+    }
+
+    *out++ = '0';
+    *out++ = 'x';
+    return put_hex(out, address, 3);
+}
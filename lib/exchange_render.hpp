@@ -0,0 +1,32 @@
+#include <vector>
+#include "base_render.hpp"
+#include "triple_buffer.hpp"
+
+#pragma once
+
+// Render for a framebuffer driven on another thread: every present is published through a triple
+// buffer, and the thread owning the real render takes the newest screen with acquire().
+class ExchangeRender : public BaseRender {
+public:
+    ExchangeRender();
+
+    void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) override;
+    const std::vector<uint8_t>* acquire();
+
+private:
+    TripleBuffer<std::vector<uint8_t>> frames;
+};
+
+ExchangeRender::ExchangeRender() : frames(std::vector<uint8_t>(SCREEN_WIDTH * SCREEN_HEIGHT)) {
+}
+
+// The slots keep their size, so copying a screen never allocates.
+void ExchangeRender::draw(const std::vector<uint8_t> &memory, const DirtyRegion &) {
+    frames.back() = memory;
+    frames.publish();
+}
+
+// Returns the screen presented since the last call, or nullptr if there is none.
+const std::vector<uint8_t>* ExchangeRender::acquire() {
+    return frames.update() ? &frames.front() : nullptr;
+}
@@ -0,0 +1,37 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <stdexcept>
+
+#pragma once
+
+// Whole file I/O with one read or write call, sized up front.
+std::vector<uint8_t> read_file(const std::string &path);
+void write_file(const std::string &path, const std::vector<uint8_t> &data);
+
+std::vector<uint8_t> read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Can't read " + path + ".");
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+    if (!file) {
+        throw std::runtime_error("Can't read " + path + ".");
+    }
+
+    return data;
+}
+
+void write_file(const std::string &path, const std::vector<uint8_t> &data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    if (!file) {
+        throw std::runtime_error("Can't write " + path + ".");
+    }
+}
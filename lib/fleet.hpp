@@ -0,0 +1,250 @@
+#include <map>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "interpreter.hpp"
+#include "scheduler.hpp"
+#include "null_render.hpp"
+#include "hash_render.hpp"
+#include "image.hpp"
+#include "movie.hpp"
+#include "work_stealing_pool.hpp"
+
+#pragma once
+
+std::vector<InputEvent> read_input_script(const std::string &path);
+
+// One headless run: a ROM, its budget in instructions and/or frames, and what to run it with.
+struct FleetJob {
+    std::string rom;
+    uint64_t cycles = 0;
+    uint64_t frames = 0;
+    uint32_t instructions_per_second = Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    Interpreter::Engine engine = Interpreter::EXECUTOR;
+    uint64_t seed = Random::DEFAULT_SEED;
+    std::string input;
+    uint64_t movie_rom_hash = 0;
+
+    bool parse_field(const std::string &name, const std::string &value, const std::filesystem::path &directory);
+};
+
+// What a job left behind. A job that couldn't load or run only has error set.
+struct FleetResult {
+    std::string error;
+
+    std::array<uint8_t, 16> registers = {};
+    uint16_t index_register = 0;
+    uint16_t program_counter = 0;
+    std::vector<uint8_t> pixels;
+    uint64_t frame_hash = 0;
+
+    uint64_t instructions = 0;
+    uint64_t frames = 0;
+    uint64_t unknown_opcodes = 0;
+    bool is_waiting_for_key = false;
+    double seconds = 0;
+};
+
+// Runs jobs over a WorkStealingPool. Every job builds its own Interpreter, Framebuffer and
+// NullRender and logs nothing, so jobs share only the ROM images and input scripts, read once
+// before the run and never written.
+class Fleet {
+public:
+    Fleet(unsigned threads = std::thread::hardware_concurrency());
+
+    unsigned threads_count() const;
+    std::vector<FleetResult> run(const std::vector<FleetJob> &jobs) const;
+
+    static FleetResult run_job(const FleetJob &job, const std::vector<uint8_t> &program, const std::vector<InputEvent> &input);
+
+private:
+    unsigned threads;
+};
+
+// Reads lines of `<frame> <key> down|up`, or the events of a recorded movie.
+std::vector<InputEvent> read_input_script(const std::string &path) {
+    auto data = read_file(path);
+    if (Movie::is_movie(data)) {
+        return Movie::decode(data).events;
+    }
+
+    std::istringstream file(std::string(data.begin(), data.end()));
+    std::vector<InputEvent> events;
+    std::string text;
+    while (std::getline(file, text)) {
+        std::istringstream fields(text);
+        uint64_t frame;
+        std::string key, action;
+
+        if (text.empty() || text[0] == '#' || !(fields >> frame >> key >> action)) {
+            continue;
+        }
+
+        events.push_back({frame, static_cast<uint8_t>(std::stoul(key, nullptr, 16) & 0xF), action == "down"});
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const InputEvent &a, const InputEvent &b) {
+        return a.frame < b.frame;
+    });
+
+    return events;
+}
+
+// Accepts rom, cycles, frames, ips, engine, seed, input and movie; paths are relative to
+// directory. A movie sets the input, seed, rate and, unless a budget came first, the frames it
+// was recorded for. Returns false for any other field name.
+bool FleetJob::parse_field(const std::string &name, const std::string &value, const std::filesystem::path &directory) {
+    auto resolve = [&](const std::string &path) {
+        return std::filesystem::path(path).is_absolute() ? path : (directory / path).string();
+    };
+
+    if (name == "rom") {
+        rom = resolve(value);
+    } else if (name == "cycles") {
+        cycles = std::stoull(value);
+    } else if (name == "frames") {
+        frames = std::stoull(value);
+    } else if (name == "ips") {
+        instructions_per_second = std::stoul(value);
+    } else if (name == "engine") {
+        if (value == "executor") {
+            engine = Interpreter::EXECUTOR;
+        } else if (value == "threaded") {
+            engine = Interpreter::THREADED;
+        } else if (value == "jit") {
+            engine = Interpreter::JIT;
+        } else {
+            throw std::runtime_error("Unknown engine " + value + ".");
+        }
+    } else if (name == "seed") {
+        seed = std::stoull(value, nullptr, 0);
+    } else if (name == "input") {
+        input = resolve(value);
+    } else if (name == "movie") {
+        input = resolve(value);
+        auto movie = Movie::load(input);
+        seed = movie.seed;
+        instructions_per_second = movie.instructions_per_second;
+        movie_rom_hash = movie.rom_hash;
+        if (cycles == 0 && frames == 0) {
+            frames = movie.frames;
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+Fleet::Fleet(unsigned threads) : threads(threads == 0 ? 1 : threads) {
+}
+
+unsigned Fleet::threads_count() const {
+    return threads;
+}
+
+std::vector<FleetResult> Fleet::run(const std::vector<FleetJob> &jobs) const {
+    std::map<std::string, std::vector<uint8_t>> programs;
+    std::map<std::string, std::vector<InputEvent>> scripts;
+    std::map<std::string, std::string> errors;
+
+    auto preload = [&](const std::string &path, auto read, auto &cache) {
+        if (path.empty() || cache.count(path) != 0 || errors.count(path) != 0) {
+            return;
+        }
+
+        try {
+            cache[path] = read(path);
+        } catch (const std::exception &error) {
+            errors[path] = error.what();
+        }
+    };
+
+    for (auto &job : jobs) {
+        preload(job.rom, read_file, programs);
+        preload(job.input, read_input_script, scripts);
+    }
+
+    std::vector<FleetResult> results(jobs.size());
+    std::vector<WorkStealingPool::Task> tasks;
+    const std::vector<InputEvent> no_input;
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        auto &job = jobs[i];
+
+        if (errors.count(job.rom) != 0) {
+            results[i].error = errors[job.rom];
+            continue;
+        }
+        if (errors.count(job.input) != 0) {
+            results[i].error = errors[job.input];
+            continue;
+        }
+
+        auto &program = programs.at(job.rom);
+        auto &input = job.input.empty() ? no_input : scripts.at(job.input);
+        tasks.push_back([&results, &job, &program, &input, i] {
+            results[i] = run_job(job, program, input);
+        });
+    }
+
+    WorkStealingPool(threads).run(std::move(tasks));
+
+    return results;
+}
+
+// Nothing presses keys but the script, so a key wait with no events left ends the job early.
+FleetResult Fleet::run_job(const FleetJob &job, const std::vector<uint8_t> &program, const std::vector<InputEvent> &input) {
+    FleetResult result;
+    auto begin = std::chrono::steady_clock::now();
+
+    try {
+        NullRender render;
+        Framebuffer framebuffer(&render);
+        Interpreter interpreter(&framebuffer);
+        Scheduler scheduler(&interpreter, job.instructions_per_second);
+
+        interpreter.log = nullptr;
+        interpreter.random.seed(job.seed);
+        interpreter.set_engine(job.engine);
+        interpreter.load(program);
+
+        if (job.movie_rom_hash != 0 && rom_hash(program) != job.movie_rom_hash) {
+            throw std::runtime_error("The movie was recorded on a different ROM.");
+        }
+
+        MoviePlayer player(input);
+        while ((job.cycles == 0 || scheduler.instructions() < job.cycles) &&
+               (job.frames == 0 || scheduler.frames() < job.frames)) {
+            player.apply(scheduler.frames(), interpreter);
+
+            if (interpreter.is_stop_execution() && player.is_finished()) {
+                break;
+            }
+
+            auto limit = job.cycles == 0 ? UINT32_MAX : std::min<uint64_t>(job.cycles - scheduler.instructions(), UINT32_MAX);
+            scheduler.run_frame(limit);
+        }
+
+        result.registers = interpreter.registers;
+        result.index_register = interpreter.index_register;
+        result.program_counter = interpreter.program_counter;
+        result.pixels = framebuffer.pixels();
+        result.frame_hash = frame_hash(result.pixels);
+
+        result.instructions = scheduler.instructions();
+        result.frames = scheduler.frames();
+        result.unknown_opcodes = interpreter.unknown_opcodes;
+        result.is_waiting_for_key = interpreter.is_stop_execution();
+    } catch (const std::exception &error) {
+        result.error = error.what();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return result;
+}
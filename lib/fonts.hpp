@@ -1,5 +1,7 @@
 #include <array>
 
+#pragma once
+
 const auto fonts = std::array<uint8_t, 80>{
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
     0x20, 0x60, 0x20, 0x20, 0x70, // 1
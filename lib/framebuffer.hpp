@@ -1,61 +1,186 @@
-#include <bitset>
 #include <array>
-#include "src/render.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "base_render.hpp"
 
+#pragma once
+
+// The screen is stored packed, one 64-bit word per row with the leftmost pixel in the top bit,
+// so a sprite row is drawn with a rotate, an XOR and an AND. A byte per pixel copy of the rows a
+// draw touched is kept up to date for BaseRender, eight pixels at a time, and the changed part of
+// the screen is collected until the next present, which the scheduler issues once per frame.
 class Framebuffer {
+public:
+    // GUEST_FRAME treats CLS as the end of the guest's frame: the screen as it was before the
+    // clear is shown instead of the half drawn one, which removes flicker.
+    enum PresentMode {
+        EVERY_FRAME,
+        GUEST_FRAME
+    };
+
 private:
     typedef BaseRender Render;
+    typedef uint64_t Row;
+    typedef std::array<std::array<uint8_t, 8>, 256> Expansion;
+
+    static const uint32_t ALL_ROWS = 0xFFFFFFFF;
 
     Render *render;
+    std::array<Row, Render::SCREEN_HEIGHT> screen;
     std::vector<uint8_t> buffer;
+    DirtyRegion dirty;
+
+    PresentMode present_mode = EVERY_FRAME;
+    std::vector<uint8_t> latched;
+    bool is_latched = false;
 
-    bool draw_pixel(uint16_t x, uint16_t y);
+    static const Expansion& expansion();
+    static Row sprite_row(uint8_t pixels, uint8_t x);
+    void unpack(uint8_t y, uint8_t column);
 
 public:
     Framebuffer(Render *render);
 
+    void set_present_mode(PresentMode mode);
     void clean();
+    void present();
+    const DirtyRegion& dirty_region() const;
+    const std::array<Row, Render::SCREEN_HEIGHT>& rows() const;
+    const std::vector<uint8_t>& pixels() const;
+    void assign(const Framebuffer &other);
+    void assign(const std::array<Row, Render::SCREEN_HEIGHT> &rows);
     uint8_t draw(uint8_t *memory, uint8_t len, uint8_t x, uint8_t y);
 };
 
 Framebuffer::Framebuffer(Render *render) : render(render) {
+    screen.fill(0);
     buffer.resize(Render::SCREEN_WIDTH * Render::SCREEN_HEIGHT);
 }
 
+void Framebuffer::set_present_mode(PresentMode mode) {
+    present_mode = mode;
+    is_latched = false;
+}
+
+// Only rows that had lit pixels become dirty.
 void Framebuffer::clean() {
-    buffer.clear();
-    render->draw(buffer);
+    if (present_mode == GUEST_FRAME) {
+        latched = buffer;
+        is_latched = true;
+    }
+
+    uint32_t rows = 0;
+    for (uint8_t y = 0; y < Render::SCREEN_HEIGHT; y++) {
+        rows |= (screen[y] != 0 ? 1u : 0u) << y;
+    }
+    dirty.add(rows, 0, Render::SCREEN_WIDTH);
+
+    screen.fill(0);
+    std::fill(buffer.begin(), buffer.end(), 0x0);
 }
 
-uint8_t Framebuffer::draw(uint8_t *memory, uint8_t len, uint8_t x, uint8_t y) {
-    bool is_cleared = false;
+// Hands the changes since the last present to the render; an unchanged screen costs nothing.
+// A latched guest frame is shown whole, and the live screen is repainted whole after it.
+void Framebuffer::present() {
+    if (is_latched) {
+        DirtyRegion everything;
+        everything.add(ALL_ROWS, 0, Render::SCREEN_WIDTH);
+
+        render->draw(latched, everything);
+        is_latched = false;
+        dirty = everything;
+        return;
+    }
 
-    for (auto n = 0; n < len; n++) {
-        auto pixel = memory[n];
+    if (dirty.empty()) {
+        return;
+    }
 
-        for (auto b = 0; b < 8; b++) {
-            if (pixel & 0x80) {
-                is_cleared = draw_pixel(x + b, y + n) || is_cleared;
-            }
+    render->draw(buffer, dirty);
+    dirty.clear();
+}
+
+const DirtyRegion& Framebuffer::dirty_region() const {
+    return dirty;
+}
 
-            pixel = pixel << 1;
+const std::array<Framebuffer::Row, Framebuffer::Render::SCREEN_HEIGHT>& Framebuffer::rows() const {
+    return screen;
+}
+
+const std::vector<uint8_t>& Framebuffer::pixels() const {
+    return buffer;
+}
+
+// Copies the screen contents of another framebuffer without drawing them; the next present
+// repaints everything.
+void Framebuffer::assign(const Framebuffer &other) {
+    screen = other.screen;
+    buffer = other.buffer;
+
+    dirty.add(ALL_ROWS, 0, Render::SCREEN_WIDTH);
+}
+
+// Replaces the screen with packed rows, e.g. from a snapshot; the next present repaints everything.
+void Framebuffer::assign(const std::array<Row, Render::SCREEN_HEIGHT> &rows) {
+    screen = rows;
+
+    for (uint8_t y = 0; y < Render::SCREEN_HEIGHT; y++) {
+        for (uint8_t column = 0; column < Render::SCREEN_WIDTH / 8; column++) {
+            unpack(y, column);
         }
     }
 
-    render->draw(buffer);
-    return is_cleared ? 1 : 0;
+    dirty.add(ALL_ROWS, 0, Render::SCREEN_WIDTH);
 }
 
-bool Framebuffer::draw_pixel(uint16_t x, uint16_t y) {
-    while (x > Render::SCREEN_WIDTH - 1) x -= Render::SCREEN_WIDTH;
-    while (x < 0) x += Render::SCREEN_WIDTH;
-    while (y > Render::SCREEN_HEIGHT - 1) y -= Render::SCREEN_HEIGHT;
-    while (y < 0) y += Render::SCREEN_HEIGHT;
+// Sprites wrap around both edges of the screen.
+uint8_t Framebuffer::draw(uint8_t *memory, uint8_t len, uint8_t x, uint8_t y) {
+    Row collision = 0;
+    uint32_t rows = 0;
+    x %= Render::SCREEN_WIDTH;
 
-    size_t position = y * Render::SCREEN_WIDTH + x;
-    buffer[position] ^= 0x1;
+    for (auto n = 0; n < len; n++) {
+        auto row = (y + n) % Render::SCREEN_HEIGHT;
+        auto line = sprite_row(memory[n], x);
+
+        collision |= screen[row] & line;
+        screen[row] ^= line;
+        rows |= (line != 0 ? 1u : 0u) << row;
+        unpack(row, x / 8);
+        unpack(row, x / 8 + 1);
+    }
+
+    dirty.add(rows, x, 8);
+    return collision != 0 ? 1 : 0;
+}
 
-    return !buffer[position];
+// Places the sprite byte at column x, rotating the bits that fall off the right edge to the left.
+Framebuffer::Row Framebuffer::sprite_row(uint8_t pixels, uint8_t x) {
+    Row line = static_cast<Row>(pixels) << (Render::SCREEN_WIDTH - 8);
+    return (line >> x) | (line << ((Render::SCREEN_WIDTH - x) % Render::SCREEN_WIDTH));
 }
 
+// Maps a byte of packed pixels to its eight byte per pixel values.
+const Framebuffer::Expansion& Framebuffer::expansion() {
+    static const Expansion table = [] {
+        Expansion table;
+        for (auto pixels = 0; pixels < 256; pixels++) {
+            for (auto b = 0; b < 8; b++) {
+                table[pixels][b] = (pixels >> (7 - b)) & 0x1;
+            }
+        }
+        return table;
+    }();
 
+    return table;
+}
+
+// Refreshes the eight pixels of row y starting at column * 8; columns wrap like sprites do.
+void Framebuffer::unpack(uint8_t y, uint8_t column) {
+    column %= Render::SCREEN_WIDTH / 8;
+    uint8_t pixels = screen[y] >> (Render::SCREEN_WIDTH - 8 - column * 8);
+
+    std::memcpy(&buffer[y * Render::SCREEN_WIDTH + column * 8], expansion()[pixels].data(), 8);
+}
@@ -1,15 +1,23 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <iomanip>
+#include <type_traits>
 
+#pragma once
+
+// Formats num as 0x and two lowercase digits per byte, in a stack buffer rather than a stream.
 template <typename T>
 std::string to_hex(T num)
 {
-    std::stringbuf buf;
-    std::ostream os(&buf);
+    static const char digits[] = "0123456789abcdef";
+    char buffer[2 + sizeof(T) * 2] = {'0', 'x'};
 
-    os << "0x" << std::setfill('0') << std::setw(sizeof(T) * 2)
-       << std::hex << num;
+    auto value = static_cast<std::make_unsigned_t<T>>(num);
+    for (size_t i = sizeof(buffer) - 1; i >= 2; i--) {
+        buffer[i] = digits[value & 0xF];
+        value >>= 4;
+    }
 
-    return buf.str().c_str();
-}
\ No newline at end of file
+    return std::string(buffer, sizeof(buffer));
+}
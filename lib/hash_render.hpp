@@ -0,0 +1,60 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include "base_render.hpp"
+#include "functions.hpp"
+#include "serialization.hpp"
+
+#pragma once
+
+// 64-bit hash of a screen. Eight pixels are packed into a byte with one multiply, and the
+// resulting 256 bytes are mixed a word at a time.
+uint64_t frame_hash(const std::vector<uint8_t> &pixels) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (size_t i = 0; i + 64 <= pixels.size(); i += 64) {
+        uint64_t packed = 0;
+
+        for (auto b = 0; b < 8; b++) {
+            uint64_t word;
+            std::memcpy(&word, &pixels[i + b * 8], 8);
+            packed = packed << 8 | ((word & 0x0101010101010101) * 0x0102040810204080) >> 56;
+        }
+
+        hash = fnv1a(hash, packed);
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+// Writes one line per presented screen, `<present> <hash>`, for comparing runs without images.
+class HashRender : public BaseRender {
+public:
+    HashRender(const std::string &path);
+
+    void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) override;
+    uint64_t last_hash() const;
+
+private:
+    std::ofstream out;
+    uint64_t presents = 0;
+    uint64_t hash = 0;
+};
+
+HashRender::HashRender(const std::string &path) : out(path) {
+    if (!out) {
+        throw std::runtime_error("Can't write " + path + ".");
+    }
+}
+
+void HashRender::draw(const std::vector<uint8_t> &memory, const DirtyRegion &) {
+    hash = frame_hash(memory);
+    out << presents++ << ' ' << to_hex(hash) << '\n';
+}
+
+uint64_t HashRender::last_hash() const {
+    return hash;
+}
@@ -0,0 +1,143 @@
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "file.hpp"
+
+#pragma once
+
+// Image files for screen captures. Encoders take 8-bit RGB; to_rgb turns a byte per pixel screen,
+// as Framebuffer presents it, into white on black. PNG output is uncompressed (stored deflate
+// blocks) and needs no zlib.
+std::vector<uint8_t> to_rgb(const std::vector<uint8_t> &pixels);
+std::vector<uint8_t> encode_ppm(const std::vector<uint8_t> &rgb, uint16_t width, uint16_t height);
+std::vector<uint8_t> decode_ppm(const std::vector<uint8_t> &image, uint16_t &width, uint16_t &height);
+std::vector<uint8_t> encode_png(const std::vector<uint8_t> &rgb, uint16_t width, uint16_t height);
+
+std::vector<uint8_t> to_rgb(const std::vector<uint8_t> &pixels) {
+    std::vector<uint8_t> rgb;
+    rgb.reserve(pixels.size() * 3);
+
+    for (auto pixel : pixels) {
+        uint8_t value = pixel ? 0xFF : 0x00;
+        rgb.insert(rgb.end(), {value, value, value});
+    }
+
+    return rgb;
+}
+
+std::vector<uint8_t> encode_ppm(const std::vector<uint8_t> &rgb, uint16_t width, uint16_t height) {
+    auto header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+
+    std::vector<uint8_t> image(header.begin(), header.end());
+    image.insert(image.end(), rgb.begin(), rgb.begin() + static_cast<size_t>(width) * height * 3);
+
+    return image;
+}
+
+// Reads a binary PPM (P6, 8-bit) back into a byte per pixel screen; any non-black pixel is lit.
+std::vector<uint8_t> decode_ppm(const std::vector<uint8_t> &image, uint16_t &width, uint16_t &height) {
+    std::string text(image.begin(), image.end());
+    std::istringstream header(text);
+
+    std::string magic;
+    uint32_t max_value = 0;
+    header >> magic >> width >> height >> max_value;
+    if (!header || magic != "P6" || max_value != 255) {
+        throw std::runtime_error("Unsupported PPM image.");
+    }
+
+    size_t offset = static_cast<size_t>(header.tellg()) + 1;
+    size_t size = static_cast<size_t>(width) * height;
+    if (image.size() < offset + size * 3) {
+        throw std::runtime_error("Truncated PPM image.");
+    }
+
+    std::vector<uint8_t> pixels(size);
+    for (size_t i = 0; i < size; i++) {
+        auto rgb = &image[offset + i * 3];
+        pixels[i] = (rgb[0] | rgb[1] | rgb[2]) != 0 ? 0x1 : 0x0;
+    }
+
+    return pixels;
+}
+
+uint32_t png_crc(const uint8_t *data, size_t length, uint32_t crc = 0xFFFFFFFF) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> table;
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (auto k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+void push_big_endian(std::vector<uint8_t> &out, uint32_t value) {
+    out.insert(out.end(), {uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value)});
+}
+
+void push_png_chunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data) {
+    push_big_endian(out, data.size());
+
+    auto start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    push_big_endian(out, png_crc(&out[start], out.size() - start) ^ 0xFFFFFFFF);
+}
+
+std::vector<uint8_t> encode_png(const std::vector<uint8_t> &rgb, uint16_t width, uint16_t height) {
+    static const uint16_t STORED_BLOCK_SIZE = 0xFFFF;
+
+    // Scanlines of 8-bit RGB, each behind filter type 0.
+    size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    for (auto y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + y * stride, rgb.begin() + (y + 1) * stride);
+    }
+
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    for (size_t offset = 0; offset == 0 || offset < raw.size(); offset += STORED_BLOCK_SIZE) {
+        uint16_t length = std::min<size_t>(raw.size() - offset, STORED_BLOCK_SIZE);
+        bool is_last = offset + length == raw.size();
+
+        zlib.insert(zlib.end(), {uint8_t(is_last), uint8_t(length), uint8_t(length >> 8),
+                                 uint8_t(~length), uint8_t(~length >> 8)});
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+    }
+
+    uint32_t a = 1, b = 0;
+    for (auto byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    push_big_endian(zlib, b << 16 | a);
+
+    std::vector<uint8_t> header;
+    push_big_endian(header, width);
+    push_big_endian(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+
+    std::vector<uint8_t> image = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    push_png_chunk(image, "IHDR", header);
+    push_png_chunk(image, "IDAT", zlib);
+    push_png_chunk(image, "IEND", {});
+
+    return image;
+}
@@ -0,0 +1,107 @@
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <iomanip>
+#include <sstream>
+#include <iostream>
+#include <condition_variable>
+#include "base_render.hpp"
+#include "image.hpp"
+
+#pragma once
+
+// Saves every n-th presented screen as <directory>/frame_000042.png (or .ppm). Encoding and file
+// writes happen on a background thread, so the emulation only pays for copying the screen.
+class ImageRender : public BaseRender {
+public:
+    enum Format {
+        PNG,
+        PPM
+    };
+
+    ImageRender(const std::string &directory, Format format = PNG, uint32_t every = 1);
+    ~ImageRender();
+
+    void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) override;
+
+private:
+    struct Image {
+        uint64_t index;
+        std::vector<uint8_t> pixels;
+    };
+
+    std::string directory;
+    Format format;
+    uint32_t every;
+    uint64_t presents = 0;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Image> pending;
+    bool is_closing = false;
+    std::thread writer;
+
+    void write_images();
+    std::string path(uint64_t index) const;
+};
+
+ImageRender::ImageRender(const std::string &directory, Format format, uint32_t every) :
+        directory(directory), format(format), every(every == 0 ? 1 : every) {
+    writer = std::thread(&ImageRender::write_images, this);
+}
+
+// Waits until every queued screen is written.
+ImageRender::~ImageRender() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_closing = true;
+    }
+    available.notify_one();
+    writer.join();
+}
+
+void ImageRender::draw(const std::vector<uint8_t> &memory, const DirtyRegion &) {
+    auto index = presents++;
+    if (index % every != 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({index, memory});
+    }
+    available.notify_one();
+}
+
+void ImageRender::write_images() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        available.wait(lock, [this] { return is_closing || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+
+        auto image = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        try {
+            auto rgb = to_rgb(image.pixels);
+            auto data = format == PNG ? encode_png(rgb, SCREEN_WIDTH, SCREEN_HEIGHT)
+                                      : encode_ppm(rgb, SCREEN_WIDTH, SCREEN_HEIGHT);
+            write_file(path(image.index), data);
+        } catch (const std::exception &error) {
+            std::cerr << error.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+std::string ImageRender::path(uint64_t index) const {
+    std::ostringstream name;
+    name << directory << "/frame_" << std::setfill('0') << std::setw(6) << index << (format == PNG ? ".png" : ".ppm");
+
+    return name.str();
+}
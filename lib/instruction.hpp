@@ -1,4 +1,8 @@
 #include <array>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
 
 #pragma once
 
@@ -39,82 +43,74 @@ enum Instruction {
     LD_VX_I = 0xF065
 };
 
-uint16_t instruction_mask(Instruction instruction) {
-    switch (instruction) {
-        case ::CLS:
-            return 0xFFFF;
-        case ::RET:
-            return 0xFFFF;
-        case ::JP_ADDR:
-            return 0xF000;
-        case ::CALL_ADDR:
-            return 0xF000;
-        case ::SE_VX_BYTE:
-            return 0xF000;
-        case ::SNE_VX_BYTE:
-            return 0xF000;
-        case ::SE_VX_VY:
-            return 0xF00F;
-        case ::LD_VX_BYTE:
-            return 0xF000;
-        case ::ADD_VX_BYTE:
-            return 0xF000;
-        case ::LD_VX_VY:
-            return 0xF00F;
-        case ::OR_VX_VY:
-            return 0xF00F;
-        case ::AND_VX_VY:
-            return 0xF00F;
-        case ::XOR_VX_VY:
-            return 0xF00F;
-        case ::ADD_VX_VY_CARRY:
-            return 0xF00F;
-        case ::SUB_VX_VY:
-            return 0xF00F;
-        case ::SHR_VX_VY:
-            return 0xF00F;
-        case ::SUBN_VX_VY:
-            return 0xF00F;
-        case ::SHL_VX:
-            return 0xF00F;
-        case ::SNE_VX_VY:
-            return 0xF000;
-        case ::LD_I_ADDR:
-            return 0xF000;
-        case ::JP_V0_ADDR:
-            return 0xF000;
-        case ::RND_VX_BYTE:
-            return 0xF000;
-        case ::DRW_VX_VY_N:
-            return 0xF000;
-        case ::SKP_VX:
-            return 0xF0FF;
-        case ::SKPN_VX:
-            return 0xF0FF;
-        case ::LD_VX_DT:
-            return 0xF00F;
-        case ::LD_VX_K:
-            return 0xF00F;
-        case ::LD_DT_VX:
-            return 0xF0FF;
-        case ::LD_ST_VX:
-            return 0xF0FF;
-        case ::ADD_I_VX:
-            return 0xF0FF;
-        case ::LD_F_VX:
-            return 0xF0FF;
-        case ::LD_B_VX:
-            return 0xF0FF;
-        case ::LD_I_VX:
-            return 0xF0FF;
-        case ::LD_VX_I:
-            return 0xF0FF;
+// Everything known about each instruction, in decoding order: the opcode bits that identify it,
+// its enum identifier for reports, and its disassembly syntax (see Disassembler for the %
+// placeholders). The decoder, OpcodeStats and the Disassembler all read this table.
+struct InstructionInfo {
+    Instruction instruction;
+    uint16_t mask;
+    const char *name;
+    const char *syntax;
+};
+
+constexpr auto instruction_table = std::array<InstructionInfo, 34>{{
+        {CLS, 0xFFFF, "CLS", "CLS"},
+        {RET, 0xFFFF, "RET", "RET"},
+        {JP_ADDR, 0xF000, "JP_ADDR", "JP %a"},
+        {CALL_ADDR, 0xF000, "CALL_ADDR", "CALL %a"},
+        {SE_VX_BYTE, 0xF000, "SE_VX_BYTE", "SE %x, %k"},
+        {SNE_VX_BYTE, 0xF000, "SNE_VX_BYTE", "SNE %x, %k"},
+        {SE_VX_VY, 0xF00F, "SE_VX_VY", "SE %x, %y"},
+        {LD_VX_BYTE, 0xF000, "LD_VX_BYTE", "LD %x, %k"},
+        {ADD_VX_BYTE, 0xF000, "ADD_VX_BYTE", "ADD %x, %k"},
+        {LD_VX_VY, 0xF00F, "LD_VX_VY", "LD %x, %y"},
+        {OR_VX_VY, 0xF00F, "OR_VX_VY", "OR %x, %y"},
+        {AND_VX_VY, 0xF00F, "AND_VX_VY", "AND %x, %y"},
+        {XOR_VX_VY, 0xF00F, "XOR_VX_VY", "XOR %x, %y"},
+        {ADD_VX_VY_CARRY, 0xF00F, "ADD_VX_VY_CARRY", "ADD %x, %y"},
+        {SUB_VX_VY, 0xF00F, "SUB_VX_VY", "SUB %x, %y"},
+        {SHR_VX_VY, 0xF00F, "SHR_VX_VY", "SHR %x, %y"},
+        {SUBN_VX_VY, 0xF00F, "SUBN_VX_VY", "SUBN %x, %y"},
+        {SHL_VX, 0xF00F, "SHL_VX", "SHL %x"},
+        {SNE_VX_VY, 0xF000, "SNE_VX_VY", "SNE %x, %y"},
+        {LD_I_ADDR, 0xF000, "LD_I_ADDR", "LD I, %m"},
+        {JP_V0_ADDR, 0xF000, "JP_V0_ADDR", "JP V0, %m"},
+        {RND_VX_BYTE, 0xF000, "RND_VX_BYTE", "RND %x, %k"},
+        {DRW_VX_VY_N, 0xF000, "DRW_VX_VY_N", "DRW %x, %y, %n"},
+        {SKP_VX, 0xF0FF, "SKP_VX", "SKP %x"},
+        {SKPN_VX, 0xF0FF, "SKPN_VX", "SKNP %x"},
+        {LD_VX_DT, 0xF00F, "LD_VX_DT", "LD %x, DT"},
+        {LD_VX_K, 0xF00F, "LD_VX_K", "LD %x, K"},
+        {LD_DT_VX, 0xF0FF, "LD_DT_VX", "LD DT, %x"},
+        {LD_ST_VX, 0xF0FF, "LD_ST_VX", "LD ST, %x"},
+        {ADD_I_VX, 0xF0FF, "ADD_I_VX", "ADD I, %x"},
+        {LD_F_VX, 0xF0FF, "LD_F_VX", "LD F, %x"},
+        {LD_B_VX, 0xF0FF, "LD_B_VX", "LD B, %x"},
+        {LD_I_VX, 0xF0FF, "LD_I_VX", "LD [I], %x"},
+        {LD_VX_I, 0xF0FF, "LD_VX_I", "LD %x, [I]"}
+}};
+
+// The instructions alone, in the same order; decoding returns pointers into this array.
+constexpr auto instructions = [] {
+    std::array<Instruction, std::tuple_size<decltype(instruction_table)>::value> result{};
+    for (size_t i = 0; i < result.size(); i++) {
+        result[i] = instruction_table[i].instruction;
     }
+    return result;
+}();
+
+const InstructionInfo& instruction_info(const Instruction *instruction) {
+    return instruction_table[instruction - instructions.data()];
 }
 
-const auto instructions = std::array<Instruction, 35>{
-        CLS, RET, JP_ADDR, CALL_ADDR, SE_VX_BYTE, SNE_VX_BYTE, SE_VX_VY, LD_VX_BYTE, ADD_VX_BYTE, LD_VX_VY, OR_VX_VY,
-        AND_VX_VY, XOR_VX_VY, ADD_VX_VY_CARRY, SUB_VX_VY, SHR_VX_VY, SUBN_VX_VY, SHL_VX, SNE_VX_VY, LD_I_ADDR, JP_V0_ADDR, RND_VX_BYTE,
-        DRW_VX_VY_N, SKP_VX, SKPN_VX, LD_VX_DT, LD_VX_K, LD_DT_VX, LD_ST_VX, ADD_I_VX, LD_F_VX,
-        LD_B_VX, LD_I_VX, LD_VX_I
-};
\ No newline at end of file
+const Instruction* find_instruction(uint16_t opcode) {
+    auto predicate = [&](const Instruction &instruction) {
+        return instruction == (opcode & instruction_info(&instruction).mask);
+    };
+    auto it = std::find_if(instructions.begin(), instructions.end(), predicate);
+    if (it == instructions.end()) {
+        return nullptr;
+    }
+
+    return it;
+}
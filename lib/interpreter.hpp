@@ -2,24 +2,76 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
 #include "framebuffer.hpp"
 #include "base_interpreter.hpp"
 #include "command_executor.hpp"
+#include "threaded_executor.hpp"
+#include "jit_executor.hpp"
+#include "aot_runtime.hpp"
 #include "instruction.hpp"
+#include "decoder.hpp"
 #include "fonts.hpp"
+#include "snapshot.hpp"
+#include "file.hpp"
+
+#pragma once
 
 class Interpreter : public BaseInterpreter {
+public:
+    enum Engine {
+        EXECUTOR,
+        THREADED,
+        JIT,
+        AOT
+    };
+
 private:
     CommandExecutor executor = CommandExecutor(this);
+    ThreadedExecutor threaded = ThreadedExecutor(this);
+#if CHIP8_JIT
+    std::unique_ptr<JitExecutor> jit;
+#endif
+    std::unique_ptr<AotExecutor> aot;
+    const Decoder &decoder = Decoder::instance();
+
+    Engine engine = EXECUTOR;
+
+    // Memory as the last load left it; snapshots only store the pages that differ from it, and
+    // only restore over an image with the same hash.
+    Snapshot::Memory image;
+    uint64_t image_hash;
+
+    void set_image();
+
+    void invalidate_caches();
+    void invalidate_caches(uint16_t address, uint16_t length);
 
 public:
     Interpreter(Framebuffer *framebuffer) noexcept;
 
     void load(std::string &&filename);
+    void load(const std::vector<uint8_t> &program);
+    void set_engine(Engine engine);
+    void set_aot_program(const AotProgram *program);
+    void set_lockstep(bool enabled);
+#ifdef CHIP8_OPCODE_STATS
+    void set_opcode_stats(OpcodeStats *stats);
+#endif
 
+    std::vector<uint8_t> snapshot() const;
+    std::vector<uint8_t> full_snapshot() const;
+    void restore(const std::vector<uint8_t> &snapshot);
+    void save_snapshot(const std::string &path) const;
+    void load_snapshot(const std::string &path);
+
+    uint32_t run(uint32_t budget);
+    void step();
     uint16_t fetch_opcode();
     const Instruction* decode(uint16_t opcode);
-    void execute(const Instruction *instruction, uint16_t opcode);
+    void execute(uint16_t opcode);
     void update_timers();
 
     const bool is_stop_execution();
@@ -37,6 +89,7 @@ Interpreter::Interpreter(Framebuffer *framebuffer) noexcept {
     std::fill(keyboard.begin(), keyboard.end(), false);
 
     std::copy(fonts.begin(), fonts.end(), memory.begin());
+    set_image();
 
     stack_pointer = 0;
     sound_timer = 0;
@@ -47,18 +100,148 @@ Interpreter::Interpreter(Framebuffer *framebuffer) noexcept {
 
     stop_execution_flag = 0x0;
     continue_execution_key = 0x0;
+
+    unknown_opcodes = 0;
+    log = &std::cout;
 }
 
+// The program goes at the program counter, and has to fit in memory from there.
+void Interpreter::load(const std::vector<uint8_t> &program) {
+    if (program_counter > memory.size() || program.size() > memory.size() - program_counter) {
+        throw std::runtime_error("ROM is too large: " + std::to_string(program.size()) + " bytes.");
+    }
+
+    std::copy(program.begin(), program.end(), memory.begin() + program_counter);
+    set_image();
+    invalidate_caches();
+}
+
+// A file that can't be opened leaves memory as it was.
 void Interpreter::load(std::string &&filename) {
     std::ifstream file(filename, std::ios::in | std::ios::binary);
 
     if (file.is_open()) {
-        auto begin = std::istreambuf_iterator<char>(file);
-        auto end = std::istreambuf_iterator<char>();
-        std::copy(begin, end, memory.begin() + program_counter);
+        load(std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+    }
+}
 
-        file.close();
+// Every engine caches decoded code, so switching drops whatever was cached before.
+void Interpreter::set_engine(Engine engine) {
+#if CHIP8_JIT
+    if (engine == JIT && !jit) {
+        jit = std::make_unique<JitExecutor>(this, &executor);
+    }
+#else
+    if (engine == JIT) {
+        throw std::runtime_error("JIT engine is not supported on this platform.");
     }
+#endif
+    if (engine == AOT && !aot) {
+        throw std::runtime_error("AOT engine needs a program compiled by chip8_aot.");
+    }
+
+    this->engine = engine;
+    invalidate_caches();
+}
+
+// Attaches blocks compiled ahead of time for the loaded ROM; see AotExecutor.
+void Interpreter::set_aot_program(const AotProgram *program) {
+    aot = std::make_unique<AotExecutor>(this, &executor, program);
+}
+
+// Replays every JIT block on a shadow CommandExecutor machine and throws on the first divergence.
+void Interpreter::set_lockstep(bool enabled) {
+#if CHIP8_JIT
+    if (!jit) {
+        jit = std::make_unique<JitExecutor>(this, &executor);
+    }
+    jit->set_lockstep(enabled);
+#endif
+}
+
+#ifdef CHIP8_OPCODE_STATS
+// Only instructions the executor engine runs are counted.
+void Interpreter::set_opcode_stats(OpcodeStats *stats) {
+    executor.set_stats(stats);
+}
+#endif
+
+std::vector<uint8_t> Interpreter::snapshot() const {
+    return Snapshot::encode(*this, image, image_hash);
+}
+
+// Every page included, for callers that compare snapshots byte by byte, like Rewind.
+std::vector<uint8_t> Interpreter::full_snapshot() const {
+    return Snapshot::encode(*this, image_hash);
+}
+
+// Cheap enough for search and fuzzing loops: only memory pages that differ from the current
+// contents are copied, and only code cached for those pages is dropped.
+void Interpreter::restore(const std::vector<uint8_t> &snapshot) {
+    auto pages = Snapshot::decode(snapshot, image, image_hash, *this);
+
+    for (uint16_t page = 0; pages != 0; page++, pages >>= 1) {
+        if (pages & 0x1) {
+            invalidate_caches(page * Snapshot::PAGE_SIZE, Snapshot::PAGE_SIZE);
+        }
+    }
+}
+
+void Interpreter::save_snapshot(const std::string &path) const {
+    write_file(path, snapshot());
+}
+
+void Interpreter::load_snapshot(const std::string &path) {
+    restore(read_file(path));
+}
+
+void Interpreter::set_image() {
+    image = memory;
+    image_hash = Snapshot::hash(image);
+}
+
+void Interpreter::invalidate_caches() {
+    invalidate_caches(0, memory.size());
+}
+
+void Interpreter::invalidate_caches(uint16_t address, uint16_t length) {
+    executor.invalidate(address, length);
+    threaded.invalidate(address, length);
+#if CHIP8_JIT
+    if (jit) {
+        jit->invalidate(address, length);
+    }
+#endif
+}
+
+// Runs up to budget instructions and returns how many were executed. Stops early when the
+// guest waits for a key; the threaded, JIT and AOT engines also return after every draw.
+uint32_t Interpreter::run(uint32_t budget) {
+    uint32_t executed = 0;
+
+    if (engine == THREADED) {
+        threaded.run(budget, executed);
+        return executed;
+    }
+#if CHIP8_JIT
+    if (engine == JIT) {
+        return jit->run(budget);
+    }
+#endif
+    if (engine == AOT) {
+        return aot->run(budget);
+    }
+
+    while (executed < budget && !is_stop_execution()) {
+        executor.step();
+        executed++;
+    }
+
+    return executed;
+}
+
+void Interpreter::step() {
+    executor.step();
 }
 
 uint16_t Interpreter::fetch_opcode() {
@@ -66,19 +249,11 @@ uint16_t Interpreter::fetch_opcode() {
 }
 
 const Instruction* Interpreter::decode(uint16_t opcode) {
-    auto predicate = [&](const Instruction &instruction) {
-        return instruction == (opcode & instruction_mask(instruction));
-    };
-    auto it = std::find_if(instructions.begin(), instructions.end(), predicate);
-    if (it == instructions.end()) {
-        return nullptr;
-    }
-
-    return it;
+    return decoder.decode(opcode);
 }
 
-void Interpreter::execute(const Instruction *instruction, uint16_t opcode) {
-    executor.execute(instruction, opcode);
+void Interpreter::execute(uint16_t opcode) {
+    executor.execute(opcode);
 }
 
 void Interpreter::update_timers() {
@@ -0,0 +1,449 @@
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "base_interpreter.hpp"
+#include "framebuffer.hpp"
+#include "null_render.hpp"
+#include "command_executor.hpp"
+#include "instruction.hpp"
+#include "decoder.hpp"
+#include "functions.hpp"
+
+#pragma once
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CHIP8_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define CHIP8_JIT 0
+#endif
+
+#if CHIP8_JIT
+
+// Dynamic recompiler translating CHIP-8 basic blocks into x86-64 code operating directly on the
+// BaseInterpreter fields (rbx holds the context). Register, I and timer moves are emitted inline;
+// everything else calls back into CommandExecutor. In lockstep mode every block is replayed on a
+// shadow machine by CommandExecutor and the two states are compared. The arena is never writable
+// and executable at once: translate() opens the pages it emits into for writing and hands them
+// back as read and execute only.
+class JitExecutor {
+public:
+    JitExecutor(BaseInterpreter *interpreter, CommandExecutor *executor);
+    ~JitExecutor();
+
+    uint32_t run(uint32_t budget);
+    void invalidate(uint16_t address, uint16_t length);
+    void set_lockstep(bool enabled);
+
+private:
+    typedef uint32_t (*Code)(BaseInterpreter *context);
+
+    struct Block {
+        Code code;
+        uint16_t start;
+        uint16_t end;
+        uint32_t count;
+        bool stops;
+    };
+
+    static const uint16_t ADDRESS_MASK = 0x0FFF;
+    static const uint32_t MAX_BLOCK_LENGTH = 64;
+    static const size_t ARENA_SIZE = 1 << 20;
+    static const size_t MAX_BLOCK_CODE = MAX_BLOCK_LENGTH * 40 + 32;
+
+    BaseInterpreter *interpreter_ptr;
+    CommandExecutor *executor_ptr;
+    const Decoder &decoder = Decoder::instance();
+
+    uint8_t *arena;
+    size_t arena_used = 0;
+
+    std::array<Block, 4096> blocks;
+    std::array<uint16_t, 4096> coverage;
+
+    bool lockstep = false;
+    BaseInterpreter shadow;
+    NullRender shadow_render;
+    Framebuffer shadow_framebuffer = Framebuffer(&shadow_render);
+    CommandExecutor shadow_executor = CommandExecutor(&shadow);
+
+    static void execute_helper(JitExecutor *self, uint32_t opcode);
+    static void store_helper(JitExecutor *self, uint32_t opcode);
+
+    const Block& translate(uint16_t pc);
+    void protect(uint8_t *begin, size_t length, int protection);
+    void flush();
+    void synchronize_shadow();
+    void verify_shadow(uint16_t start, uint32_t count);
+
+    void emit(uint8_t byte);
+    void emit16(uint16_t value);
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+    void emit_field(uint8_t opcode, uint8_t reg, size_t offset);
+    void emit_call(void (*helper)(JitExecutor *self, uint32_t opcode), uint16_t pc, uint16_t opcode);
+    bool emit_native(uint16_t opcode, const Instruction *instruction);
+};
+
+JitExecutor::JitExecutor(BaseInterpreter *interpreter, CommandExecutor *executor) :
+        interpreter_ptr(interpreter), executor_ptr(executor) {
+    void *memory = mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("JIT can't allocate executable memory.");
+    }
+
+    arena = static_cast<uint8_t*>(memory);
+    flush();
+}
+
+JitExecutor::~JitExecutor() {
+    munmap(arena, ARENA_SIZE);
+}
+
+// Runs up to budget instructions, whole blocks at a time; a tail shorter than the next block is
+// finished by CommandExecutor so the count is exact. Returns after draws and on key waits.
+uint32_t JitExecutor::run(uint32_t budget) {
+    uint32_t executed = 0;
+
+    if (lockstep) {
+        synchronize_shadow();
+    }
+
+    while (executed < budget && interpreter_ptr->stop_execution_flag != 0x1) {
+        auto pc = interpreter_ptr->program_counter & ADDRESS_MASK;
+        const Block *block = &blocks[pc];
+        if (block->code == nullptr) {
+            block = &translate(pc);
+        }
+
+        if (block->count > budget - executed) {
+            while (executed < budget && interpreter_ptr->stop_execution_flag != 0x1) {
+                uint16_t address = interpreter_ptr->program_counter & ADDRESS_MASK;
+
+                executor_ptr->step();
+                executed++;
+                if (lockstep) {
+                    verify_shadow(address, 1);
+                }
+            }
+            break;
+        }
+
+        auto count = block->code(interpreter_ptr);
+        executed += count;
+
+        if (lockstep) {
+            verify_shadow(block->start, count);
+        }
+        if (block->stops) {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+// Drops translated blocks overlapping [address, address + length).
+void JitExecutor::invalidate(uint16_t address, uint16_t length) {
+    bool translated = false;
+    for (uint32_t i = 0; i < length && !translated; i++) {
+        translated = coverage[(address + i) & ADDRESS_MASK] != 0;
+    }
+    if (!translated) {
+        return;
+    }
+
+    uint32_t first = address;
+    uint32_t last = address + length;
+
+    for (auto &block : blocks) {
+        if (block.code == nullptr || block.end <= first || block.start >= last) {
+            continue;
+        }
+
+        for (auto i = block.start; i < block.end; i++) {
+            coverage[i & ADDRESS_MASK]--;
+        }
+        block.code = nullptr;
+    }
+}
+
+void JitExecutor::set_lockstep(bool enabled) {
+    lockstep = enabled;
+    flush();
+}
+
+void JitExecutor::execute_helper(JitExecutor *self, uint32_t opcode) {
+    self->executor_ptr->execute(opcode);
+}
+
+// Fx33 and Fx55 may overwrite translated code; they always end their block, so dropping the
+// running block here is safe (its code stays in the arena until the next flush).
+void JitExecutor::store_helper(JitExecutor *self, uint32_t opcode) {
+    uint16_t index = self->interpreter_ptr->index_register;
+    uint16_t length = (opcode & 0x00FF) == 0x33 ? 3 : ((opcode & 0x0F00) >> 8) + 1;
+
+    self->executor_ptr->execute(opcode);
+    self->invalidate(index, length);
+}
+
+const JitExecutor::Block& JitExecutor::translate(uint16_t pc) {
+    if (ARENA_SIZE - arena_used < MAX_BLOCK_CODE) {
+        flush();
+    }
+
+    auto &block = blocks[pc];
+    auto *code = arena + arena_used;
+    protect(code, MAX_BLOCK_CODE, PROT_READ | PROT_WRITE);
+
+    uint16_t address = pc;
+    uint32_t count = 0;
+    bool terminated = false;
+
+    block.start = pc;
+    block.stops = false;
+
+    // push rbx; mov rbx, rdi
+    emit(0x53);
+    emit(0x48); emit(0x89); emit(0xFB);
+
+    while (!terminated && count < MAX_BLOCK_LENGTH && (count == 0 || address < ADDRESS_MASK)) {
+        uint16_t opcode = interpreter_ptr->memory[address & ADDRESS_MASK] << 8 |
+                          interpreter_ptr->memory[(address + 1) & ADDRESS_MASK];
+        auto instruction = decoder.decode(opcode);
+        count++;
+
+        if (instruction == nullptr) {
+            emit_call(&JitExecutor::execute_helper, address, opcode);
+            terminated = true;
+        } else if (*instruction == ::JP_ADDR) {
+            // mov word [rbx + pc], nnn
+            emit(0x66);
+            emit_field(0xC7, 0, offsetof(BaseInterpreter, program_counter));
+            emit16(opcode & 0x0FFF);
+            terminated = true;
+        } else if (*instruction == ::LD_B_VX || *instruction == ::LD_I_VX) {
+            emit_call(&JitExecutor::store_helper, address, opcode);
+            terminated = true;
+        } else if (emit_native(opcode, instruction)) {
+            address += 2;
+            continue;
+        } else {
+            emit_call(&JitExecutor::execute_helper, address, opcode);
+
+            switch (*instruction) {
+                case ::RET:
+                case ::CALL_ADDR:
+                case ::SE_VX_BYTE:
+                case ::SNE_VX_BYTE:
+                case ::SE_VX_VY:
+                case ::SNE_VX_VY:
+                case ::JP_V0_ADDR:
+                case ::SKP_VX:
+                case ::SKPN_VX:
+                    terminated = true;
+                    break;
+                case ::CLS:
+                case ::DRW_VX_VY_N:
+                case ::LD_VX_K:
+                    terminated = true;
+                    block.stops = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        address += 2;
+    }
+
+    if (!terminated) {
+        // mov word [rbx + pc], address
+        emit(0x66);
+        emit_field(0xC7, 0, offsetof(BaseInterpreter, program_counter));
+        emit16(address);
+    }
+
+    // mov eax, count; pop rbx; ret
+    emit(0xB8); emit32(count);
+    emit(0x5B);
+    emit(0xC3);
+
+    protect(code, MAX_BLOCK_CODE, PROT_READ | PROT_EXEC);
+
+    block.code = reinterpret_cast<Code>(code);
+    block.end = address;
+    block.count = count;
+
+    for (auto i = block.start; i < block.end; i++) {
+        coverage[i & ADDRESS_MASK]++;
+    }
+
+    return block;
+}
+
+// Changes the pages holding [begin, begin + length); the first may also hold the end of an older
+// block, which is fine since nothing runs while a block is translated.
+void JitExecutor::protect(uint8_t *begin, size_t length, int protection) {
+    static const uintptr_t PAGE_MASK = ~static_cast<uintptr_t>(sysconf(_SC_PAGESIZE) - 1);
+
+    auto first = reinterpret_cast<uintptr_t>(begin) & PAGE_MASK;
+    auto last = (reinterpret_cast<uintptr_t>(begin) + length - 1) & PAGE_MASK;
+    auto end = std::min(last + ~PAGE_MASK + 1, reinterpret_cast<uintptr_t>(arena) + ARENA_SIZE);
+
+    if (mprotect(reinterpret_cast<void*>(first), end - first, protection) != 0) {
+        throw std::runtime_error("JIT can't change the protection of its code.");
+    }
+}
+
+void JitExecutor::flush() {
+    for (auto &block : blocks) {
+        block.code = nullptr;
+    }
+    std::fill(coverage.begin(), coverage.end(), 0);
+
+    arena_used = 0;
+}
+
+void JitExecutor::synchronize_shadow() {
+    shadow = *interpreter_ptr;
+    shadow.framebuffer = &shadow_framebuffer;
+    shadow.log = nullptr;
+    shadow_framebuffer.assign(*interpreter_ptr->framebuffer);
+    shadow_executor.invalidate(0, shadow.memory.size());
+}
+
+// Replays count instructions on the shadow machine and compares it against the real one. The
+// shadow starts from a copy of the random generator, so Cxkk results match exactly.
+void JitExecutor::verify_shadow(uint16_t start, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        shadow_executor.step();
+    }
+
+    std::string field;
+    if (shadow.registers != interpreter_ptr->registers) {
+        field = "registers";
+    } else if (shadow.index_register != interpreter_ptr->index_register) {
+        field = "index register";
+    } else if (shadow.program_counter != interpreter_ptr->program_counter) {
+        field = "program counter";
+    } else if (shadow.stack_pointer != interpreter_ptr->stack_pointer || shadow.stack != interpreter_ptr->stack) {
+        field = "stack";
+    } else if (shadow.delay_timer != interpreter_ptr->delay_timer || shadow.sound_timer != interpreter_ptr->sound_timer) {
+        field = "timers";
+    } else if (shadow.stop_execution_flag != interpreter_ptr->stop_execution_flag ||
+               shadow.continue_execution_key != interpreter_ptr->continue_execution_key) {
+        field = "key wait";
+    } else if (shadow.random.state() != interpreter_ptr->random.state()) {
+        field = "random state";
+    } else if (shadow.memory != interpreter_ptr->memory) {
+        field = "memory";
+    } else if (shadow_framebuffer.rows() != interpreter_ptr->framebuffer->rows()) {
+        field = "framebuffer";
+    }
+
+    if (!field.empty()) {
+        throw std::runtime_error("JIT lockstep mismatch in " + field + " after block " + to_hex(start));
+    }
+}
+
+void JitExecutor::emit(uint8_t byte) {
+    arena[arena_used++] = byte;
+}
+
+void JitExecutor::emit16(uint16_t value) {
+    std::memcpy(arena + arena_used, &value, sizeof(value));
+    arena_used += sizeof(value);
+}
+
+void JitExecutor::emit32(uint32_t value) {
+    std::memcpy(arena + arena_used, &value, sizeof(value));
+    arena_used += sizeof(value);
+}
+
+void JitExecutor::emit64(uint64_t value) {
+    std::memcpy(arena + arena_used, &value, sizeof(value));
+    arena_used += sizeof(value);
+}
+
+// <opcode> with a [rbx + disp32] memory operand.
+void JitExecutor::emit_field(uint8_t opcode, uint8_t reg, size_t offset) {
+    emit(opcode);
+    emit(0x80 | reg << 3 | 0x3);
+    emit32(offset);
+}
+
+void JitExecutor::emit_call(void (*helper)(JitExecutor *self, uint32_t opcode), uint16_t pc, uint16_t opcode) {
+    // mov word [rbx + pc], pc
+    emit(0x66);
+    emit_field(0xC7, 0, offsetof(BaseInterpreter, program_counter));
+    emit16(pc);
+
+    // mov rdi, this; mov esi, opcode; mov rax, helper; call rax
+    emit(0x48); emit(0xBF); emit64(reinterpret_cast<uint64_t>(this));
+    emit(0xBE); emit32(opcode);
+    emit(0x48); emit(0xB8); emit64(reinterpret_cast<uint64_t>(helper));
+    emit(0xFF); emit(0xD0);
+}
+
+bool JitExecutor::emit_native(uint16_t opcode, const Instruction *instruction) {
+    size_t registers = offsetof(BaseInterpreter, registers);
+    size_t vx = registers + ((opcode & 0x0F00) >> 8);
+    size_t vy = registers + ((opcode & 0x00F0) >> 4);
+    uint8_t kk = opcode & 0x00FF;
+
+    switch (*instruction) {
+        case ::LD_VX_BYTE:
+            // mov byte [vx], kk
+            emit_field(0xC6, 0, vx);
+            emit(kk);
+            return true;
+        case ::ADD_VX_BYTE:
+            // add byte [vx], kk
+            emit_field(0x80, 0, vx);
+            emit(kk);
+            return true;
+        case ::LD_VX_VY:
+        case ::OR_VX_VY:
+        case ::AND_VX_VY:
+        case ::XOR_VX_VY:
+            // mov al, [vy]; mov/or/and/xor [vx], al
+            emit_field(0x8A, 0, vy);
+            emit_field(*instruction == ::LD_VX_VY ? 0x88 : *instruction == ::OR_VX_VY ? 0x08 :
+                       *instruction == ::AND_VX_VY ? 0x20 : 0x30, 0, vx);
+            return true;
+        case ::LD_I_ADDR:
+            // mov word [i], nnn
+            emit(0x66);
+            emit_field(0xC7, 0, offsetof(BaseInterpreter, index_register));
+            emit16(opcode & 0x0FFF);
+            return true;
+        case ::LD_F_VX:
+            // movzx eax, byte [vx]; lea eax, [rax + rax * 4]; mov [i], ax
+            emit(0x0F);
+            emit_field(0xB6, 0, vx);
+            emit(0x8D); emit(0x04); emit(0x80);
+            emit(0x66);
+            emit_field(0x89, 0, offsetof(BaseInterpreter, index_register));
+            return true;
+        case ::LD_VX_DT:
+            // mov al, [dt]; mov [vx], al
+            emit_field(0x8A, 0, offsetof(BaseInterpreter, delay_timer));
+            emit_field(0x88, 0, vx);
+            return true;
+        case ::LD_DT_VX:
+        case ::LD_ST_VX:
+            // mov al, [vx]; mov [dt/st], al
+            emit_field(0x8A, 0, vx);
+            emit_field(0x88, 0, *instruction == ::LD_DT_VX ?
+                       offsetof(BaseInterpreter, delay_timer) : offsetof(BaseInterpreter, sound_timer));
+            return true;
+        default:
+            return false;
+    }
+}
+
+#endif
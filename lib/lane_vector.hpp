@@ -0,0 +1,219 @@
+#include <cstdint>
+#include <cstddef>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#pragma once
+
+// A SIMD register of 8-bit lanes for BatchExecutor: AVX2 or SSE2, whichever the compiler targets,
+// and a single byte without either. Masks hold 0xFF in selected lanes and 0x00 in the others.
+struct LaneVector {
+#if defined(__AVX2__)
+    typedef __m256i Type;
+    static const size_t WIDTH = 32;
+#elif defined(__SSE2__)
+    typedef __m128i Type;
+    static const size_t WIDTH = 16;
+#else
+    typedef uint8_t Type;
+    static const size_t WIDTH = 1;
+#endif
+
+    static const char* name();
+
+    static Type load(const uint8_t *source);
+    static void store(uint8_t *destination, Type value);
+    static Type broadcast(uint8_t value);
+
+    static Type add(Type a, Type b);
+    static Type sub(Type a, Type b);
+    static Type bit_and(Type a, Type b);
+    static Type bit_or(Type a, Type b);
+    static Type bit_xor(Type a, Type b);
+    static Type shift_right(Type a);
+    static Type top_bit(Type a);
+
+    static Type equal(Type a, Type b);
+    static Type greater(Type a, Type b);
+    static Type select(Type mask, Type a, Type b);
+};
+
+// Unsigned comparison; shifts move by one bit.
+#if defined(__AVX2__)
+
+const char* LaneVector::name() {
+    return "AVX2";
+}
+
+LaneVector::Type LaneVector::load(const uint8_t *source) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+}
+
+void LaneVector::store(uint8_t *destination, Type value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), value);
+}
+
+LaneVector::Type LaneVector::broadcast(uint8_t value) {
+    return _mm256_set1_epi8(static_cast<char>(value));
+}
+
+LaneVector::Type LaneVector::add(Type a, Type b) {
+    return _mm256_add_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::sub(Type a, Type b) {
+    return _mm256_sub_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::bit_and(Type a, Type b) {
+    return _mm256_and_si256(a, b);
+}
+
+LaneVector::Type LaneVector::bit_or(Type a, Type b) {
+    return _mm256_or_si256(a, b);
+}
+
+LaneVector::Type LaneVector::bit_xor(Type a, Type b) {
+    return _mm256_xor_si256(a, b);
+}
+
+LaneVector::Type LaneVector::shift_right(Type a) {
+    return _mm256_and_si256(_mm256_srli_epi16(a, 1), broadcast(0x7F));
+}
+
+LaneVector::Type LaneVector::top_bit(Type a) {
+    return _mm256_and_si256(_mm256_srli_epi16(a, 7), broadcast(0x01));
+}
+
+LaneVector::Type LaneVector::equal(Type a, Type b) {
+    return _mm256_cmpeq_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::greater(Type a, Type b) {
+    return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(a, b), _mm256_setzero_si256()), broadcast(0xFF));
+}
+
+LaneVector::Type LaneVector::select(Type mask, Type a, Type b) {
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+#elif defined(__SSE2__)
+
+const char* LaneVector::name() {
+    return "SSE2";
+}
+
+LaneVector::Type LaneVector::load(const uint8_t *source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+void LaneVector::store(uint8_t *destination, Type value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value);
+}
+
+LaneVector::Type LaneVector::broadcast(uint8_t value) {
+    return _mm_set1_epi8(static_cast<char>(value));
+}
+
+LaneVector::Type LaneVector::add(Type a, Type b) {
+    return _mm_add_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::sub(Type a, Type b) {
+    return _mm_sub_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::bit_and(Type a, Type b) {
+    return _mm_and_si128(a, b);
+}
+
+LaneVector::Type LaneVector::bit_or(Type a, Type b) {
+    return _mm_or_si128(a, b);
+}
+
+LaneVector::Type LaneVector::bit_xor(Type a, Type b) {
+    return _mm_xor_si128(a, b);
+}
+
+LaneVector::Type LaneVector::shift_right(Type a) {
+    return _mm_and_si128(_mm_srli_epi16(a, 1), broadcast(0x7F));
+}
+
+LaneVector::Type LaneVector::top_bit(Type a) {
+    return _mm_and_si128(_mm_srli_epi16(a, 7), broadcast(0x01));
+}
+
+LaneVector::Type LaneVector::equal(Type a, Type b) {
+    return _mm_cmpeq_epi8(a, b);
+}
+
+LaneVector::Type LaneVector::greater(Type a, Type b) {
+    return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(a, b), _mm_setzero_si128()), broadcast(0xFF));
+}
+
+LaneVector::Type LaneVector::select(Type mask, Type a, Type b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#else
+
+const char* LaneVector::name() {
+    return "scalar";
+}
+
+LaneVector::Type LaneVector::load(const uint8_t *source) {
+    return *source;
+}
+
+void LaneVector::store(uint8_t *destination, Type value) {
+    *destination = value;
+}
+
+LaneVector::Type LaneVector::broadcast(uint8_t value) {
+    return value;
+}
+
+LaneVector::Type LaneVector::add(Type a, Type b) {
+    return a + b;
+}
+
+LaneVector::Type LaneVector::sub(Type a, Type b) {
+    return a - b;
+}
+
+LaneVector::Type LaneVector::bit_and(Type a, Type b) {
+    return a & b;
+}
+
+LaneVector::Type LaneVector::bit_or(Type a, Type b) {
+    return a | b;
+}
+
+LaneVector::Type LaneVector::bit_xor(Type a, Type b) {
+    return a ^ b;
+}
+
+LaneVector::Type LaneVector::shift_right(Type a) {
+    return a >> 1;
+}
+
+LaneVector::Type LaneVector::top_bit(Type a) {
+    return a >> 7;
+}
+
+LaneVector::Type LaneVector::equal(Type a, Type b) {
+    return a == b ? 0xFF : 0x00;
+}
+
+LaneVector::Type LaneVector::greater(Type a, Type b) {
+    return a > b ? 0xFF : 0x00;
+}
+
+LaneVector::Type LaneVector::select(Type mask, Type a, Type b) {
+    return mask ? a : b;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include "interpreter.hpp"
+#include "scheduler.hpp"
+#include "file.hpp"
+#include "serialization.hpp"
+
+#pragma once
+
+// A key transition, applied before the scheduler frame with that number runs.
+struct InputEvent {
+    uint64_t frame;
+    uint8_t key;
+    bool is_pressed;
+};
+
+// A recorded run: key transitions plus everything else that decides how the run goes, which is
+// the ROM, the Cxkk seed and the instruction rate. frames is the length of the recording.
+// Stored little endian: a fixed header, then per event the frame delta as LEB128 and a byte
+// with the key in the low nibble and bit 4 set for presses.
+struct Movie {
+    static const uint16_t VERSION = 1;
+
+    uint64_t rom_hash = 0;
+    uint64_t seed = Random::DEFAULT_SEED;
+    uint32_t instructions_per_second = Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    uint64_t frames = 0;
+    std::vector<InputEvent> events;
+
+    std::vector<uint8_t> encode() const;
+    static Movie decode(const std::vector<uint8_t> &data);
+    static bool is_movie(const std::vector<uint8_t> &data);
+
+    void save(const std::string &path) const;
+    static Movie load(const std::string &path);
+
+private:
+    static const uint32_t MAGIC = 0x564D3843;
+    static const size_t HEADER_SIZE = 38;
+};
+
+// Presses and releases keys on an interpreter as the frames of a movie or input script go by.
+class MoviePlayer {
+public:
+    MoviePlayer(const std::vector<InputEvent> &events);
+
+    void apply(uint64_t frame, Interpreter &interpreter);
+    bool is_finished() const;
+
+private:
+    const std::vector<InputEvent> &events;
+    size_t next = 0;
+};
+
+std::vector<uint8_t> Movie::encode() const {
+    std::vector<uint8_t> out;
+    out.reserve(HEADER_SIZE + events.size() * 2);
+
+    put_le(out, MAGIC, 4);
+    put_le(out, VERSION, 2);
+    put_le(out, rom_hash, 8);
+    put_le(out, seed, 8);
+    put_le(out, instructions_per_second, 4);
+    put_le(out, frames, 8);
+    put_le(out, events.size(), 4);
+
+    uint64_t frame = 0;
+    for (auto &event : events) {
+        put_leb128(out, event.frame - frame);
+        frame = event.frame;
+        out.push_back((event.key & 0xF) | (event.is_pressed ? 0x10 : 0x00));
+    }
+
+    return out;
+}
+
+Movie Movie::decode(const std::vector<uint8_t> &data) {
+    const uint8_t *in = data.data();
+    const uint8_t *end = in + data.size();
+
+    if (data.size() < HEADER_SIZE || get_le(in, 4) != MAGIC) {
+        throw std::runtime_error("Not a movie.");
+    }
+    if (get_le(in, 2) != VERSION) {
+        throw std::runtime_error("Unsupported movie version.");
+    }
+
+    Movie movie;
+    movie.rom_hash = get_le(in, 8);
+    movie.seed = get_le(in, 8);
+    movie.instructions_per_second = get_le(in, 4);
+    movie.frames = get_le(in, 8);
+    uint32_t count = get_le(in, 4);
+
+    auto next = [&] {
+        if (in == end) {
+            throw std::runtime_error("Movie is truncated.");
+        }
+        return *in++;
+    };
+
+    uint64_t frame = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        frame += get_leb128(next);
+
+        if (in == end) {
+            throw std::runtime_error("Movie is truncated.");
+        }
+        movie.events.push_back({frame, static_cast<uint8_t>(*in & 0xF), (*in & 0x10) != 0});
+        in++;
+    }
+
+    return movie;
+}
+
+bool Movie::is_movie(const std::vector<uint8_t> &data) {
+    const uint8_t *in = data.data();
+    return data.size() >= HEADER_SIZE && get_le(in, 4) == MAGIC;
+}
+
+void Movie::save(const std::string &path) const {
+    write_file(path, encode());
+}
+
+Movie Movie::load(const std::string &path) {
+    return decode(read_file(path));
+}
+
+// Events must be in frame order.
+MoviePlayer::MoviePlayer(const std::vector<InputEvent> &events) : events(events) {
+}
+
+// Applies every event due before frame runs.
+void MoviePlayer::apply(uint64_t frame, Interpreter &interpreter) {
+    for (; next < events.size() && events[next].frame <= frame; next++) {
+        if (events[next].is_pressed) {
+            interpreter.key_pressed(events[next].key);
+        } else {
+            interpreter.key_released(events[next].key);
+        }
+    }
+}
+
+bool MoviePlayer::is_finished() const {
+    return next == events.size();
+}
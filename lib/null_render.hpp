@@ -0,0 +1,12 @@
+#include "base_render.hpp"
+
+#pragma once
+
+// Render that discards every frame, for framebuffers nobody looks at.
+class NullRender : public BaseRender {
+public:
+    void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) override;
+};
+
+void NullRender::draw(const std::vector<uint8_t> &, const DirtyRegion &) {
+}
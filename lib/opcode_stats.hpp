@@ -0,0 +1,193 @@
+#include <array>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <csignal>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include "instruction.hpp"
+
+#pragma once
+
+// Execution counts per instruction, plus the host time of one execution in every SAMPLE_PERIOD
+// of that instruction, bucketed by log2 of the nanoseconds. Only the CommandExecutor feeds it,
+// and only in builds with CHIP8_OPCODE_STATS; elsewhere the executor has no hook at all.
+class OpcodeStats {
+public:
+    enum Format {
+        TABLE,
+        JSON
+    };
+
+    static const uint32_t SAMPLE_PERIOD = 16;
+    static constexpr size_t BUCKETS = 32;
+    static constexpr size_t UNKNOWN = std::tuple_size<decltype(instructions)>::value;
+
+    struct Entry {
+        uint64_t count = 0;
+        uint64_t samples = 0;
+        uint64_t nanoseconds = 0;
+        std::array<uint64_t, BUCKETS> histogram{};
+    };
+
+    static size_t index(const Instruction *instruction);
+    static const char* name(size_t index);
+    static Format parse_format(const std::string &value);
+
+    bool count(size_t index);
+    void sample(size_t index, uint64_t nanoseconds);
+    const Entry& entry(size_t index) const;
+    void reset();
+
+    void print(std::ostream &out, Format format) const;
+
+    static void dump_on_signal(int signal);
+    static bool take_dump_request();
+
+private:
+    static volatile std::sig_atomic_t dump_requested;
+
+    std::array<Entry, UNKNOWN + 1> entries;
+
+    void print_table(std::ostream &out) const;
+    void print_json(std::ostream &out) const;
+};
+
+volatile std::sig_atomic_t OpcodeStats::dump_requested = 0;
+
+// Unknown opcodes, which decode to nullptr, share the last entry.
+size_t OpcodeStats::index(const Instruction *instruction) {
+    return instruction == nullptr ? UNKNOWN : instruction - instructions.data();
+}
+
+const char* OpcodeStats::name(size_t index) {
+    return index < UNKNOWN ? instruction_table[index].name : "UNKNOWN";
+}
+
+OpcodeStats::Format OpcodeStats::parse_format(const std::string &value) {
+    if (value == "table") {
+        return TABLE;
+    }
+    if (value == "json") {
+        return JSON;
+    }
+
+    throw std::runtime_error("Unknown opcode stats format " + value + ".");
+}
+
+// Counts an execution and says whether this one should be timed.
+bool OpcodeStats::count(size_t index) {
+    return entries[index].count++ % SAMPLE_PERIOD == 0;
+}
+
+// Bucket b holds times below 2^b nanoseconds that don't fit bucket b - 1; the last one takes
+// everything longer.
+void OpcodeStats::sample(size_t index, uint64_t nanoseconds) {
+    auto &entry = entries[index];
+    size_t bucket = nanoseconds == 0 ? 0 : 64 - __builtin_clzll(nanoseconds);
+
+    entry.samples++;
+    entry.nanoseconds += nanoseconds;
+    entry.histogram[std::min(bucket, BUCKETS - 1)]++;
+}
+
+const OpcodeStats::Entry& OpcodeStats::entry(size_t index) const {
+    return entries[index];
+}
+
+void OpcodeStats::reset() {
+    entries.fill(Entry());
+}
+
+void OpcodeStats::print(std::ostream &out, Format format) const {
+    if (format == JSON) {
+        print_json(out);
+    } else {
+        print_table(out);
+    }
+}
+
+// The handler only sets a flag; the emulation loop polls take_dump_request() between frames.
+void OpcodeStats::dump_on_signal(int signal) {
+    std::signal(signal, [](int) {
+        dump_requested = 1;
+    });
+}
+
+bool OpcodeStats::take_dump_request() {
+    if (!dump_requested) {
+        return false;
+    }
+
+    dump_requested = 0;
+    return true;
+}
+
+// Busiest instructions first. The estimated time is the sampled mean times the count.
+void OpcodeStats::print_table(std::ostream &out) const {
+    std::vector<size_t> order;
+    uint64_t total = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].count > 0) {
+            order.push_back(i);
+            total += entries[i].count;
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entries[a].count > entries[b].count;
+    });
+
+    out << std::left << std::setw(16) << "instruction" << std::right << std::setw(14) << "count"
+        << std::setw(9) << "share" << std::setw(12) << "mean ns" << std::setw(10) << "max ns"
+        << std::setw(14) << "est. ms" << std::endl;
+
+    for (auto i : order) {
+        auto &entry = entries[i];
+        double mean = entry.samples > 0 ? static_cast<double>(entry.nanoseconds) / entry.samples : 0;
+
+        size_t highest = 0;
+        for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+            if (entry.histogram[bucket] > 0) {
+                highest = bucket;
+            }
+        }
+
+        out << std::left << std::setw(16) << name(i) << std::right << std::setw(14) << entry.count
+            << std::setw(8) << std::fixed << std::setprecision(2) << 100.0 * entry.count / total << "%"
+            << std::setw(12) << std::setprecision(1) << mean << std::setw(10) << "<" + std::to_string(1ull << highest)
+            << std::setw(14) << std::setprecision(3) << mean * entry.count / 1e6 << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+// One object per executed instruction; histogram[b] counts samples below 2^b nanoseconds.
+void OpcodeStats::print_json(std::ostream &out) const {
+    out << "{\"sample_period\": " << SAMPLE_PERIOD << ", \"instructions\": {";
+
+    bool is_first = true;
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto &entry = entries[i];
+        if (entry.count == 0) {
+            continue;
+        }
+
+        out << (is_first ? "" : ", ") << "\"" << name(i) << "\": {\"count\": " << entry.count
+            << ", \"samples\": " << entry.samples << ", \"nanoseconds\": " << entry.nanoseconds << ", \"histogram\": [";
+
+        size_t used = BUCKETS;
+        while (used > 0 && entry.histogram[used - 1] == 0) {
+            used--;
+        }
+        for (size_t bucket = 0; bucket < used; bucket++) {
+            out << (bucket > 0 ? ", " : "") << entry.histogram[bucket];
+        }
+
+        out << "]}";
+        is_first = false;
+    }
+
+    out << "}}" << std::endl;
+}
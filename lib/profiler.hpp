@@ -0,0 +1,302 @@
+#include <map>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+#include <stdexcept>
+#include "interpreter.hpp"
+#include "instruction.hpp"
+#include "decoder.hpp"
+#include "disassembler.hpp"
+#include "functions.hpp"
+
+#pragma once
+
+// Guest profiler: steps the interpreter one instruction at a time and counts every address it
+// executes. Control flow that doesn't fall through to the next instruction marks basic block
+// starts, and CALL/RET drive a shadow call stack kept as a tree of subroutine entries, so each
+// instruction is also charged to the stack it ran under. Works with every engine, since run(1)
+// is exact on all of them.
+class Profiler {
+public:
+    // Calls nested deeper than the guest stack are charged to the deepest frame.
+    static const size_t MAX_DEPTH = 16;
+
+    Profiler();
+
+    uint32_t run(Interpreter &interpreter, uint32_t budget);
+
+    uint64_t hits(uint16_t address) const;
+    uint64_t total() const;
+
+    void write_listing(std::ostream &out) const;
+    void write_folded(std::ostream &out) const;
+    void save(const std::string &path) const;
+
+private:
+    static const uint16_t ADDRESS_MASK = 0x0FFF;
+    static const uint16_t ROOT = 0xFFFF;
+
+    // A node per distinct call path; address is the subroutine entry, or ROOT for the top level.
+    struct Node {
+        uint16_t address;
+        uint32_t parent;
+        uint64_t hits;
+        std::map<uint16_t, uint32_t> children;
+    };
+
+    struct Block {
+        uint16_t begin;
+        uint16_t end;
+        uint64_t hits;
+    };
+
+    const Decoder &decoder = Decoder::instance();
+    Disassembler disassembler;
+
+    std::array<uint64_t, 4096> address_hits{};
+    std::array<uint16_t, 4096> opcodes{};
+    std::array<bool, 4096> leaders{};
+    std::map<uint16_t, uint64_t> calls;
+    uint64_t total_hits = 0;
+
+    std::vector<Node> nodes;
+    uint32_t current = 0;
+    size_t depth = 0;
+    size_t overflow = 0;
+
+    void record(uint16_t pc, uint16_t opcode, uint16_t next);
+    void enter(uint16_t address);
+    void leave();
+
+    std::vector<Block> blocks() const;
+    std::string path(uint32_t node) const;
+    std::string frame_name(uint16_t address) const;
+    double percent(uint64_t hits) const;
+};
+
+Profiler::Profiler() {
+    nodes.push_back({ROOT, 0, 0, {}});
+}
+
+// Runs up to budget instructions like Interpreter::run, recording each one.
+uint32_t Profiler::run(Interpreter &interpreter, uint32_t budget) {
+    uint32_t executed = 0;
+
+    while (executed < budget && !interpreter.is_stop_execution()) {
+        uint16_t pc = interpreter.program_counter & ADDRESS_MASK;
+        uint16_t opcode = interpreter.memory[pc] << 8 | interpreter.memory[(pc + 1) & ADDRESS_MASK];
+
+        if (interpreter.run(1) == 0) {
+            break;
+        }
+
+        executed++;
+        record(pc, opcode, interpreter.program_counter & ADDRESS_MASK);
+    }
+
+    return executed;
+}
+
+uint64_t Profiler::hits(uint16_t address) const {
+    return address_hits[address & ADDRESS_MASK];
+}
+
+uint64_t Profiler::total() const {
+    return total_hits;
+}
+
+// Opcodes are kept as last executed, so code the guest rewrote lists as it last ran.
+void Profiler::record(uint16_t pc, uint16_t opcode, uint16_t next) {
+    address_hits[pc]++;
+    opcodes[pc] = opcode;
+    nodes[current].hits++;
+    total_hits++;
+
+    if (next != ((pc + 2) & ADDRESS_MASK)) {
+        leaders[next] = true;
+    }
+
+    auto instruction = decoder.decode(opcode);
+    if (instruction == nullptr) {
+        return;
+    }
+
+    switch (*instruction) {
+        case ::CALL_ADDR:
+            leaders[(pc + 2) & ADDRESS_MASK] = true;
+            calls[next]++;
+            disassembler.add_label(next, Disassembler::CALL);
+            enter(next);
+            break;
+        case ::RET:
+            leaders[(pc + 2) & ADDRESS_MASK] = true;
+            leave();
+            break;
+        case ::JP_ADDR:
+            leaders[(pc + 2) & ADDRESS_MASK] = true;
+            disassembler.add_label(next, Disassembler::JUMP);
+            break;
+        case ::JP_V0_ADDR:
+        case ::SE_VX_BYTE:
+        case ::SNE_VX_BYTE:
+        case ::SE_VX_VY:
+        case ::SNE_VX_VY:
+        case ::SKP_VX:
+        case ::SKPN_VX:
+            leaders[(pc + 2) & ADDRESS_MASK] = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void Profiler::enter(uint16_t address) {
+    if (depth == MAX_DEPTH) {
+        overflow++;
+        return;
+    }
+
+    auto child = nodes[current].children.find(address);
+    if (child == nodes[current].children.end()) {
+        nodes.push_back({address, current, 0, {}});
+        child = nodes[current].children.emplace(address, nodes.size() - 1).first;
+    }
+
+    current = child->second;
+    depth++;
+}
+
+// A RET without a matching CALL, like one left over from a snapshot, stays at the top level.
+void Profiler::leave() {
+    if (overflow > 0) {
+        overflow--;
+    } else if (current != 0) {
+        current = nodes[current].parent;
+        depth--;
+    }
+}
+
+// Runs of executed instructions, split at every block start seen.
+std::vector<Profiler::Block> Profiler::blocks() const {
+    std::vector<Block> result;
+
+    for (uint16_t address = 0; address < address_hits.size(); address++) {
+        if (address_hits[address] == 0) {
+            continue;
+        }
+
+        bool is_continued = !result.empty() && result.back().end == address && !leaders[address];
+        if (!is_continued) {
+            result.push_back({address, address, 0});
+        }
+
+        result.back().end = address + 2;
+        result.back().hits += address_hits[address];
+    }
+
+    return result;
+}
+
+// The frames from the top level down to node, separated by semicolons.
+std::string Profiler::path(uint32_t node) const {
+    std::string result = frame_name(nodes[node].address);
+
+    while (node != 0) {
+        node = nodes[node].parent;
+        result = frame_name(nodes[node].address) + ";" + result;
+    }
+
+    return result;
+}
+
+std::string Profiler::frame_name(uint16_t address) const {
+    if (address == ROOT) {
+        return "main";
+    }
+
+    char name[Disassembler::LINE_SIZE];
+    disassembler.format_label(address, name);
+    return name;
+}
+
+double Profiler::percent(uint64_t hits) const {
+    return total_hits > 0 ? 100.0 * hits / total_hits : 0;
+}
+
+// A summary of subroutines, with self time and time including callees, then every executed
+// instruction by address, grouped into basic blocks, with its share of all hits.
+void Profiler::write_listing(std::ostream &out) const {
+    auto all = blocks();
+
+    std::map<uint16_t, uint64_t> self;
+    std::map<uint16_t, uint64_t> inclusive;
+    for (uint32_t node = 1; node < nodes.size(); node++) {
+        self[nodes[node].address] += nodes[node].hits;
+
+        // Recursive paths hold an entry more than once; the hits count once for it.
+        std::vector<uint16_t> seen;
+        for (uint32_t ancestor = node; ancestor != 0; ancestor = nodes[ancestor].parent) {
+            auto address = nodes[ancestor].address;
+            if (std::find(seen.begin(), seen.end(), address) == seen.end()) {
+                seen.push_back(address);
+                inclusive[address] += nodes[node].hits;
+            }
+        }
+    }
+
+    out << std::fixed << std::setprecision(2);
+    out << "; " << total_hits << " instructions, " << all.size() << " blocks, " << calls.size() << " subroutines" << std::endl;
+    out << ";" << std::endl;
+    out << "; subroutine        calls     self    total" << std::endl;
+    for (auto &call : calls) {
+        out << "; " << std::left << std::setw(14) << frame_name(call.first) << std::right << std::setw(10) << call.second
+            << std::setw(8) << percent(self[call.first]) << "%" << std::setw(8) << percent(inclusive[call.first]) << "%"
+            << std::endl;
+    }
+
+    for (auto &block : all) {
+        out << std::endl;
+        if (disassembler.label(block.begin) != Disassembler::NONE) {
+            out << frame_name(block.begin) << ":" << std::endl;
+        }
+        out << "; block " << to_hex(block.begin) << "-" << to_hex(static_cast<uint16_t>(block.end - 2)) << ", "
+            << (block.end - block.begin) / 2 << " instructions, " << percent(block.hits) << "%" << std::endl;
+
+        for (uint16_t address = block.begin; address < block.end; address += 2) {
+            char line[Disassembler::LINE_SIZE];
+            disassembler.format_line(address, opcodes[address], line);
+            out << std::setw(8) << percent(address_hits[address]) << "% " << std::setw(12) << address_hits[address]
+                << "  " << line << std::endl;
+        }
+    }
+
+    out << std::defaultfloat;
+}
+
+// One line per call path that executed anything, with its hits, as flamegraph.pl and similar
+// tools expect.
+void Profiler::write_folded(std::ostream &out) const {
+    for (uint32_t node = 0; node < nodes.size(); node++) {
+        if (nodes[node].hits > 0) {
+            out << path(node) << " " << nodes[node].hits << std::endl;
+        }
+    }
+}
+
+// Writes the listing to path and the folded stacks next to it, to path + ".folded".
+void Profiler::save(const std::string &path) const {
+    std::ofstream listing(path);
+    std::ofstream folded(path + ".folded");
+
+    if (!listing.is_open() || !folded.is_open()) {
+        throw std::runtime_error("Can't write the profile to " + path + ".");
+    }
+
+    write_listing(listing);
+    write_folded(folded);
+}
@@ -0,0 +1,51 @@
+#include <cstdint>
+
+#pragma once
+
+// xorshift64* generator for Cxkk. Every interpreter owns one, so runs are reproducible and
+// instances on different threads share no state.
+class Random {
+public:
+    static const uint64_t DEFAULT_SEED = 0xC8;
+
+    Random(uint64_t seed = DEFAULT_SEED);
+
+    void seed(uint64_t seed);
+    uint8_t next_byte();
+
+    uint64_t state() const;
+    void restore(uint64_t state);
+
+private:
+    uint64_t current;
+};
+
+Random::Random(uint64_t seed) {
+    this->seed(seed);
+}
+
+// Spreads the seed with a splitmix64 step. The all-zero state would stay zero forever, so
+// restore() never accepts it.
+void Random::seed(uint64_t seed) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    restore(z ^ (z >> 31));
+}
+
+uint8_t Random::next_byte() {
+    current ^= current >> 12;
+    current ^= current << 25;
+    current ^= current >> 27;
+
+    return (current * 0x2545F4914F6CDD1D) >> 56;
+}
+
+uint64_t Random::state() const {
+    return current;
+}
+
+// Continues a sequence from a state() value, e.g. one kept in a snapshot.
+void Random::restore(uint64_t state) {
+    current = state != 0 ? state : 0x9E3779B97F4A7C15;
+}
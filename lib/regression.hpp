@@ -0,0 +1,204 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <filesystem>
+#include "fleet.hpp"
+#include "image.hpp"
+
+#pragma once
+
+// A manifest line: `rom=<path> cycles=<n>|frames=<n> [ips=<n>] [engine=executor|threaded|jit]
+// [seed=<n>] [input=<path>] [movie=<path>] [hash=<hex>] [registers=<V0..VF as 32 hex digits>]
+// [frame=<ppm>]`.
+// Paths are relative to the manifest; blank lines and lines starting with # are skipped.
+struct RegressionCase {
+    size_t line = 0;
+    FleetJob job;
+
+    bool has_hash = false;
+    uint64_t hash = 0;
+    std::string registers;
+    std::string frame;
+};
+
+struct RegressionResult {
+    bool passed = true;
+    std::string message;
+    uint64_t hash = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> expected_pixels;
+};
+
+// Runs every case of a manifest as a Fleet job and checks what it left behind.
+class RegressionSuite {
+public:
+    RegressionSuite(const std::string &manifest);
+
+    const std::vector<RegressionCase>& cases() const;
+    std::vector<RegressionResult> run(unsigned threads) const;
+
+    static RegressionResult check(const RegressionCase &test, FleetResult &&run);
+    static std::vector<uint8_t> diff_image(const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual);
+
+private:
+    std::vector<RegressionCase> entries;
+
+    static std::string register_dump(const std::array<uint8_t, 16> &registers);
+};
+
+RegressionSuite::RegressionSuite(const std::string &manifest) {
+    std::ifstream file(manifest);
+    if (!file) {
+        throw std::runtime_error("Can't read " + manifest + ".");
+    }
+
+    auto directory = std::filesystem::path(manifest).parent_path();
+
+    std::string text;
+    for (size_t line = 1; std::getline(file, text); line++) {
+        auto location = manifest + ":" + std::to_string(line) + ": ";
+        std::istringstream fields(text);
+        std::string field;
+        RegressionCase test;
+        test.line = line;
+
+        while (fields >> field) {
+            if (field[0] == '#') {
+                break;
+            }
+
+            auto separator = field.find('=');
+            if (separator == std::string::npos) {
+                throw std::runtime_error(location + "expected name=value, got " + field + ".");
+            }
+            auto name = field.substr(0, separator);
+            auto value = field.substr(separator + 1);
+
+            try {
+                if (test.job.parse_field(name, value, directory)) {
+                    continue;
+                }
+
+                if (name == "hash") {
+                    test.has_hash = true;
+                    test.hash = std::stoull(value, nullptr, 16);
+                } else if (name == "registers") {
+                    test.registers = value;
+                } else if (name == "frame") {
+                    test.frame = std::filesystem::path(value).is_absolute() ? value : (directory / value).string();
+                } else {
+                    throw std::runtime_error("unknown field " + name + ".");
+                }
+            } catch (const std::logic_error &) {
+                throw std::runtime_error(location + "bad value " + value + " for " + name + ".");
+            } catch (const std::exception &error) {
+                throw std::runtime_error(location + error.what());
+            }
+        }
+
+        if (test.job.rom.empty()) {
+            continue;
+        }
+        if (test.job.cycles == 0 && test.job.frames == 0) {
+            throw std::runtime_error(location + "needs cycles or frames.");
+        }
+
+        entries.push_back(test);
+    }
+}
+
+const std::vector<RegressionCase>& RegressionSuite::cases() const {
+    return entries;
+}
+
+std::vector<RegressionResult> RegressionSuite::run(unsigned threads) const {
+    std::vector<FleetJob> jobs;
+    for (auto &test : entries) {
+        jobs.push_back(test.job);
+    }
+
+    auto runs = Fleet(threads).run(jobs);
+
+    std::vector<RegressionResult> results;
+    for (size_t i = 0; i < entries.size(); i++) {
+        results.push_back(check(entries[i], std::move(runs[i])));
+    }
+
+    return results;
+}
+
+// Failures to load or run a case are reported as a failed result rather than thrown.
+RegressionResult RegressionSuite::check(const RegressionCase &test, FleetResult &&run) {
+    RegressionResult result;
+
+    if (!run.error.empty()) {
+        result.passed = false;
+        result.message = run.error;
+        return result;
+    }
+
+    result.pixels = std::move(run.pixels);
+    result.hash = run.frame_hash;
+
+    if (test.has_hash && result.hash != test.hash) {
+        result.passed = false;
+        result.message += "hash " + to_hex(result.hash) + " expected " + to_hex(test.hash) + "; ";
+    }
+
+    auto registers = register_dump(run.registers);
+    if (!test.registers.empty() && registers != test.registers) {
+        result.passed = false;
+        result.message += "registers " + registers + " expected " + test.registers + "; ";
+    }
+
+    if (!test.frame.empty()) {
+        try {
+            uint16_t width, height;
+            result.expected_pixels = decode_ppm(read_file(test.frame), width, height);
+
+            if (width != BaseRender::SCREEN_WIDTH || height != BaseRender::SCREEN_HEIGHT) {
+                result.passed = false;
+                result.message += "frame " + test.frame + " isn't 64x32; ";
+                result.expected_pixels.clear();
+            } else if (result.expected_pixels != result.pixels) {
+                result.passed = false;
+                result.message += "frame differs from " + test.frame + "; ";
+            }
+        } catch (const std::exception &error) {
+            result.passed = false;
+            result.message += error.what();
+        }
+    }
+
+    return result;
+}
+
+// White where both screens are lit, red where only the expected one is, green where only the
+// actual one is.
+std::vector<uint8_t> RegressionSuite::diff_image(const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual) {
+    std::vector<uint8_t> rgb;
+    rgb.reserve(actual.size() * 3);
+
+    for (size_t i = 0; i < actual.size(); i++) {
+        uint8_t was = i < expected.size() && expected[i] ? 0xFF : 0x00;
+        uint8_t is = actual[i] ? 0xFF : 0x00;
+
+        rgb.insert(rgb.end(), {was, is, uint8_t(was & is)});
+    }
+
+    return rgb;
+}
+
+std::string RegressionSuite::register_dump(const std::array<uint8_t, 16> &registers) {
+    std::ostringstream dump;
+    dump << std::hex << std::uppercase << std::setfill('0');
+
+    for (auto value : registers) {
+        dump << std::setw(2) << +value;
+    }
+
+    return dump.str();
+}
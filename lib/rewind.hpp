@@ -0,0 +1,175 @@
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "interpreter.hpp"
+#include "serialization.hpp"
+
+#pragma once
+
+// A bounded history of frames to step back through. Each capture stores the XOR of the new state
+// with the previous one, run length encoded, so bytes a frame didn't touch cost nothing; XOR-ing
+// the newest delta into the newest state gives the frame before it. The deltas live in one ring
+// of capacity bytes, and the oldest frames are dropped when it fills up. A run of frames that
+// change nothing, like a guest waiting for a key, shares one record with a repeat count.
+class Rewind {
+public:
+    static const size_t DEFAULT_CAPACITY = 8 << 20;
+
+    Rewind(Interpreter *interpreter, size_t capacity = DEFAULT_CAPACITY);
+
+    void capture();
+    bool step_back();
+    void clear();
+
+    size_t frames() const;
+    size_t size() const;
+
+private:
+    struct Record {
+        size_t begin;
+        size_t size;
+        size_t repeats;
+    };
+
+    Interpreter *interpreter_ptr;
+    std::vector<uint8_t> ring;
+    std::deque<Record> records;
+    size_t used = 0;
+    size_t frames_count = 0;
+
+    // The last captured state, as a snapshot with every page, and the delta being built.
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> delta;
+
+    void encode(const std::vector<uint8_t> &state);
+    void push();
+    void apply(const Record &record);
+};
+
+Rewind::Rewind(Interpreter *interpreter, size_t capacity) : interpreter_ptr(interpreter) {
+    ring.resize(capacity);
+}
+
+// Call once per frame. The first capture only records the starting point.
+void Rewind::capture() {
+    auto state = interpreter_ptr->full_snapshot();
+
+    if (!current.empty()) {
+        encode(state);
+        push();
+    }
+
+    current = std::move(state);
+}
+
+// Restores the frame captured before the newest one and makes it the newest; false when there
+// is no such frame left.
+bool Rewind::step_back() {
+    if (records.empty()) {
+        return false;
+    }
+
+    frames_count--;
+    if (--records.back().repeats > 0) {
+        return true;
+    }
+
+    apply(records.back());
+    used -= records.back().size;
+    records.pop_back();
+
+    interpreter_ptr->restore(current);
+    return true;
+}
+
+void Rewind::clear() {
+    records.clear();
+    used = 0;
+    frames_count = 0;
+    current.clear();
+}
+
+size_t Rewind::frames() const {
+    return frames_count;
+}
+
+// Bytes of the ring in use.
+size_t Rewind::size() const {
+    return used;
+}
+
+// Runs of unchanged bytes become a count; changed ones follow their count verbatim. Trailing
+// unchanged bytes are left out. Counts are LEB128.
+void Rewind::encode(const std::vector<uint8_t> &state) {
+    delta.clear();
+
+    size_t i = 0;
+    while (i < state.size()) {
+        size_t same = i;
+        while (same < state.size() && state[same] == current[same]) {
+            same++;
+        }
+        if (same == state.size()) {
+            break;
+        }
+
+        size_t changed = same;
+        while (changed < state.size() && state[changed] != current[changed]) {
+            changed++;
+        }
+
+        put_leb128(delta, same - i);
+        put_leb128(delta, changed - same);
+        for (size_t j = same; j < changed; j++) {
+            delta.push_back(state[j] ^ current[j]);
+        }
+
+        i = changed;
+    }
+}
+
+// A delta that doesn't fit even in an empty ring ends the history there.
+void Rewind::push() {
+    if (delta.size() > ring.size()) {
+        records.clear();
+        used = 0;
+        frames_count = 0;
+        return;
+    }
+
+    frames_count++;
+    if (delta.empty() && !records.empty() && records.back().size == 0) {
+        records.back().repeats++;
+        return;
+    }
+
+    while (used + delta.size() > ring.size()) {
+        used -= records.front().size;
+        frames_count -= records.front().repeats;
+        records.pop_front();
+    }
+
+    size_t begin = records.empty() ? 0 : (records.front().begin + used) % ring.size();
+    for (size_t i = 0; i < delta.size(); i++) {
+        ring[(begin + i) % ring.size()] = delta[i];
+    }
+
+    records.push_back({begin, delta.size(), 1});
+    used += delta.size();
+}
+
+void Rewind::apply(const Record &record) {
+    size_t offset = 0;
+    auto next = [&] {
+        return ring[(record.begin + offset++) % ring.size()];
+    };
+
+    size_t position = 0;
+    while (offset < record.size) {
+        position += get_leb128(next);
+        size_t changed = get_leb128(next);
+        for (size_t j = 0; j < changed; j++) {
+            current[position++] ^= next();
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "interpreter.hpp"
+#include "profiler.hpp"
+
+#pragma once
+
+// Splits the CPU rate into 60 Hz frames: every frame runs its share of the instruction budget,
+// then ticks the delay and sound timers exactly once, whatever the CPU rate is, and presents the
+// screen.
+//
+// Frames with a large budget start with a short probe for idle loops, like a JP to itself or a
+// Fx07 / 3xkk / 1nnn wait on the delay timer. Nothing but the timers and the keys can end such a
+// loop, and both only change between frames, so once the machine is back in a state it was in
+// before, every further pass through the loop ends in that same state. The whole passes left in
+// the frame are counted as executed without running them; what remains runs as usual, so the
+// frame ends exactly where it would have.
+//
+// With a profiler attached, it runs the frames instead, and idle loops are not skipped, so every
+// instruction is counted.
+class Scheduler {
+public:
+    static const uint32_t FRAME_RATE = 60;
+    static const uint32_t DEFAULT_INSTRUCTIONS_PER_SECOND = 700;
+    static const uint32_t IDLE_PROBE_LENGTH = 32;
+
+    Scheduler(Interpreter *interpreter, uint32_t instructions_per_second = DEFAULT_INSTRUCTIONS_PER_SECOND);
+
+    void set_instructions_per_second(uint32_t instructions_per_second);
+    void set_idle_skipping(bool enabled);
+    void set_profiler(Profiler *profiler);
+    uint32_t run_frame(uint32_t limit = UINT32_MAX);
+
+    uint64_t frames() const;
+    uint64_t instructions() const;
+    uint64_t elided() const;
+
+private:
+    // Everything an instruction without side effects can change: V0-VF, stack, I, PC, SP, timers.
+    typedef std::array<uint8_t, 16 + 32 + 7> IdleState;
+
+    static constexpr uint32_t MAX_PROBE_BACKOFF = 16;
+
+    Interpreter *interpreter_ptr;
+    uint32_t instructions_per_second;
+    uint32_t budget_remainder = 0;
+    Profiler *profiler_ptr = nullptr;
+
+    uint64_t frames_count = 0;
+    uint64_t instructions_count = 0;
+    uint64_t elided_count = 0;
+
+    // A probe that finds no loop skips the next probe_backoff frames, doubling up to the maximum.
+    bool is_idle_skipping = true;
+    uint32_t probe_delay = 0;
+    uint32_t probe_backoff = 1;
+    std::array<IdleState, IDLE_PROBE_LENGTH + 1> history;
+
+    uint32_t skip_idle_loop(uint32_t budget);
+    uint32_t probe(uint32_t budget, uint32_t &period);
+    void capture(IdleState &state) const;
+    static bool is_side_effect_free(const Instruction *instruction);
+};
+
+Scheduler::Scheduler(Interpreter *interpreter, uint32_t instructions_per_second) :
+        interpreter_ptr(interpreter), instructions_per_second(instructions_per_second) {
+}
+
+void Scheduler::set_instructions_per_second(uint32_t instructions_per_second) {
+    this->instructions_per_second = instructions_per_second;
+    budget_remainder = 0;
+}
+
+// Counts elided instructions as executed, so budgets and rates mean the same with or without it.
+void Scheduler::set_idle_skipping(bool enabled) {
+    is_idle_skipping = enabled;
+    probe_delay = 0;
+    probe_backoff = 1;
+}
+
+void Scheduler::set_profiler(Profiler *profiler) {
+    profiler_ptr = profiler;
+}
+
+// Runs one frame of at most limit instructions and returns the number executed. Rates that don't
+// divide by 60 carry the remainder over, so every second runs exactly instructions_per_second.
+uint32_t Scheduler::run_frame(uint32_t limit) {
+    uint64_t total = static_cast<uint64_t>(instructions_per_second) + budget_remainder;
+    uint32_t budget = std::min<uint64_t>(total / FRAME_RATE, limit);
+    budget_remainder = total % FRAME_RATE;
+
+    uint32_t executed = 0;
+    if (profiler_ptr != nullptr) {
+        executed = profiler_ptr->run(*interpreter_ptr, budget);
+    } else if (is_idle_skipping && budget > 2 * IDLE_PROBE_LENGTH) {
+        executed = skip_idle_loop(budget);
+    }
+
+    while (executed < budget && !interpreter_ptr->is_stop_execution()) {
+        executed += interpreter_ptr->run(budget - executed);
+    }
+
+    interpreter_ptr->update_timers();
+    interpreter_ptr->framebuffer->present();
+
+    frames_count++;
+    instructions_count += executed;
+
+    return executed;
+}
+
+uint64_t Scheduler::frames() const {
+    return frames_count;
+}
+
+uint64_t Scheduler::instructions() const {
+    return instructions_count;
+}
+
+// Instructions counted as executed without running them.
+uint64_t Scheduler::elided() const {
+    return elided_count;
+}
+
+// Returns the instructions the probe ran plus those elided.
+uint32_t Scheduler::skip_idle_loop(uint32_t budget) {
+    if (probe_delay > 0) {
+        probe_delay--;
+        return 0;
+    }
+
+    uint32_t period;
+    uint32_t executed = probe(budget, period);
+    if (period == 0) {
+        probe_delay = probe_backoff;
+        probe_backoff = std::min(probe_backoff * 2, MAX_PROBE_BACKOFF);
+        return executed;
+    }
+
+    uint32_t skipped = (budget - executed) / period * period;
+    elided_count += skipped;
+    probe_backoff = 1;
+
+    return executed + skipped;
+}
+
+// Single steps up to IDLE_PROBE_LENGTH instructions without side effects until the machine returns
+// to a state it was in before; period is then the length of the loop, otherwise 0.
+uint32_t Scheduler::probe(uint32_t budget, uint32_t &period) {
+    uint32_t executed = 0;
+    period = 0;
+    capture(history[0]);
+
+    while (executed < IDLE_PROBE_LENGTH && executed < budget && !interpreter_ptr->is_stop_execution()) {
+        auto pc = interpreter_ptr->program_counter & 0x0FFF;
+        uint16_t opcode = interpreter_ptr->memory[pc] << 8 | interpreter_ptr->memory[(pc + 1) & 0x0FFF];
+        if (!is_side_effect_free(interpreter_ptr->decode(opcode)) || interpreter_ptr->run(1) == 0) {
+            break;
+        }
+
+        executed++;
+        capture(history[executed]);
+        for (uint32_t i = 0; i < executed; i++) {
+            if (history[i] == history[executed]) {
+                period = executed - i;
+                return executed;
+            }
+        }
+    }
+
+    return executed;
+}
+
+void Scheduler::capture(IdleState &state) const {
+    auto data = state.data();
+
+    std::memcpy(data, interpreter_ptr->registers.data(), 16);
+    std::memcpy(data + 16, interpreter_ptr->stack.data(), 32);
+    std::memcpy(data + 48, &interpreter_ptr->index_register, 2);
+    std::memcpy(data + 50, &interpreter_ptr->program_counter, 2);
+    data[52] = interpreter_ptr->stack_pointer;
+    data[53] = interpreter_ptr->delay_timer;
+    data[54] = interpreter_ptr->sound_timer;
+}
+
+// Instructions that only touch IdleState and read nothing that changes within a frame. Draws,
+// stores, Cxkk, Fx0A and unknown opcodes end the probe.
+bool Scheduler::is_side_effect_free(const Instruction *instruction) {
+    if (instruction == nullptr) {
+        return false;
+    }
+
+    switch (*instruction) {
+        case ::CLS:
+        case ::DRW_VX_VY_N:
+        case ::RND_VX_BYTE:
+        case ::LD_VX_K:
+        case ::LD_B_VX:
+        case ::LD_I_VX:
+            return false;
+        default:
+            return true;
+    }
+}
@@ -0,0 +1,82 @@
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#pragma once
+
+// Building blocks shared by the snapshot, rewind and movie formats: fixed width little endian
+// integers, LEB128 counts and 64-bit FNV-1a.
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+static constexpr uint64_t FNV_PRIME = 0x100000001B3;
+
+void put_le(std::vector<uint8_t> &out, uint64_t value, size_t bytes);
+uint64_t get_le(const uint8_t *&in, size_t bytes);
+void put_leb128(std::vector<uint8_t> &out, uint64_t value);
+template <typename Source>
+uint64_t get_leb128(Source next);
+
+uint64_t fnv1a(uint64_t hash, uint64_t value);
+uint64_t fnv1a(const uint8_t *data, size_t size);
+uint64_t rom_hash(const std::vector<uint8_t> &program);
+
+void put_le(std::vector<uint8_t> &out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out.push_back(value >> (i * 8));
+    }
+}
+
+// The caller checks that bytes are left.
+uint64_t get_le(const uint8_t *&in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(*in++) << (i * 8);
+    }
+
+    return value;
+}
+
+// Seven bits per byte, low bits first, with the top bit set on every byte but the last.
+void put_leb128(std::vector<uint8_t> &out, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(value != 0 ? byte | 0x80 : byte);
+    } while (value != 0);
+}
+
+// next() returns the following byte, and may throw when there is none.
+template <typename Source>
+uint64_t get_leb128(Source next) {
+    uint64_t value = 0;
+    for (size_t shift = 0;; shift += 7) {
+        if (shift > 63) {
+            throw std::runtime_error("LEB128 value is too long.");
+        }
+
+        uint8_t byte = next();
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+// One FNV-1a step, for callers that mix in whole words rather than bytes.
+uint64_t fnv1a(uint64_t hash, uint64_t value) {
+    return (hash ^ value) * FNV_PRIME;
+}
+
+uint64_t fnv1a(const uint8_t *data, size_t size) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash = fnv1a(hash, data[i]);
+    }
+
+    return hash;
+}
+
+// Ties movies and snapshots to the ROM or memory image they were made on.
+uint64_t rom_hash(const std::vector<uint8_t> &program) {
+    return fnv1a(program.data(), program.size());
+}
@@ -0,0 +1,187 @@
+#include <array>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include "base_interpreter.hpp"
+#include "framebuffer.hpp"
+#include "serialization.hpp"
+
+#pragma once
+
+// Savestate blob, little endian: a fixed size header with the CPU state, keyboard, generator
+// state and packed screen, then the 256 byte memory pages that differ from the image the ROM was
+// loaded into, in address order. A bit per page in the header says which pages follow, and the
+// FNV-1a hash of the image ties the blob to the ROM it was saved with.
+class Snapshot {
+public:
+    typedef std::array<uint8_t, 4096> Memory;
+
+    static const uint16_t VERSION = 2;
+    static const size_t PAGE_SIZE = 256;
+    static const size_t HEADER_SIZE = 347;
+
+    static uint64_t hash(const Memory &image);
+
+    static std::vector<uint8_t> encode(const BaseInterpreter &interpreter, const Memory &image, uint64_t image_hash);
+    static std::vector<uint8_t> encode(const BaseInterpreter &interpreter, uint64_t image_hash);
+    static uint16_t decode(const std::vector<uint8_t> &snapshot, const Memory &image, uint64_t image_hash,
+                           BaseInterpreter &interpreter);
+
+private:
+    static const uint32_t MAGIC = 0x53384843;
+    static const size_t PAGES = 4096 / PAGE_SIZE;
+
+    static std::vector<uint8_t> encode_pages(const BaseInterpreter &interpreter, uint64_t image_hash, uint16_t pages);
+};
+
+uint64_t Snapshot::hash(const Memory &image) {
+    return fnv1a(image.data(), image.size());
+}
+
+std::vector<uint8_t> Snapshot::encode(const BaseInterpreter &interpreter, const Memory &image, uint64_t image_hash) {
+    uint16_t pages = 0;
+    for (size_t page = 0; page < PAGES; page++) {
+        auto offset = page * PAGE_SIZE;
+        if (std::memcmp(&interpreter.memory[offset], &image[offset], PAGE_SIZE) != 0) {
+            pages |= 1 << page;
+        }
+    }
+
+    return encode_pages(interpreter, image_hash, pages);
+}
+
+// Stores every page, so blobs of the same machine always have the same size and layout.
+std::vector<uint8_t> Snapshot::encode(const BaseInterpreter &interpreter, uint64_t image_hash) {
+    return encode_pages(interpreter, image_hash, 0xFFFF);
+}
+
+std::vector<uint8_t> Snapshot::encode_pages(const BaseInterpreter &interpreter, uint64_t image_hash, uint16_t pages) {
+    std::vector<uint8_t> out;
+    out.reserve(HEADER_SIZE + __builtin_popcount(pages) * PAGE_SIZE);
+
+    put_le(out, MAGIC, 4);
+    put_le(out, VERSION, 2);
+    put_le(out, pages, 2);
+    put_le(out, image_hash, 8);
+
+    out.insert(out.end(), interpreter.registers.begin(), interpreter.registers.end());
+    for (auto address : interpreter.stack) {
+        put_le(out, address, 2);
+    }
+
+    uint16_t keys = 0;
+    for (size_t key = 0; key < interpreter.keyboard.size(); key++) {
+        keys |= (interpreter.keyboard[key] ? 1 : 0) << key;
+    }
+
+    put_le(out, interpreter.stack_pointer, 1);
+    put_le(out, interpreter.sound_timer, 1);
+    put_le(out, interpreter.delay_timer, 1);
+    put_le(out, interpreter.stop_execution_flag, 1);
+    put_le(out, interpreter.continue_execution_key, 1);
+    put_le(out, interpreter.index_register, 2);
+    put_le(out, interpreter.program_counter, 2);
+    put_le(out, keys, 2);
+    put_le(out, interpreter.random.state(), 8);
+    put_le(out, interpreter.unknown_opcodes, 8);
+
+    for (auto row : interpreter.framebuffer->rows()) {
+        put_le(out, row, 8);
+    }
+
+    for (size_t page = 0; page < PAGES; page++) {
+        if (pages & (1 << page)) {
+            auto begin = interpreter.memory.begin() + page * PAGE_SIZE;
+            out.insert(out.end(), begin, begin + PAGE_SIZE);
+        }
+    }
+
+    return out;
+}
+
+// Checks the whole blob, including that the image it was saved with is the one loaded now and
+// that the stack pointer and key wait state are in range, before touching the interpreter.
+// Returns a bit per memory page whose contents changed, so callers only need to drop code cached
+// for those.
+uint16_t Snapshot::decode(const std::vector<uint8_t> &snapshot, const Memory &image, uint64_t image_hash,
+                          BaseInterpreter &interpreter) {
+    const uint8_t *in = snapshot.data();
+
+    if (snapshot.size() < HEADER_SIZE || get_le(in, 4) != MAGIC) {
+        throw std::runtime_error("Not a snapshot.");
+    }
+    if (get_le(in, 2) != VERSION) {
+        throw std::runtime_error("Unsupported snapshot version.");
+    }
+
+    uint16_t pages = get_le(in, 2);
+    if (snapshot.size() != HEADER_SIZE + __builtin_popcount(pages) * PAGE_SIZE) {
+        throw std::runtime_error("Snapshot is truncated.");
+    }
+    if (get_le(in, 8) != image_hash) {
+        throw std::runtime_error("Snapshot was saved with a different ROM loaded.");
+    }
+
+    const uint8_t *registers = in;
+    in += interpreter.registers.size();
+    const uint8_t *stack = in;
+    in += interpreter.stack.size() * 2;
+
+    uint8_t stack_pointer = get_le(in, 1);
+    uint8_t sound_timer = get_le(in, 1);
+    uint8_t delay_timer = get_le(in, 1);
+    uint8_t stop_execution_flag = get_le(in, 1);
+    uint8_t continue_execution_key = get_le(in, 1);
+
+    if (stack_pointer > interpreter.stack.size()) {
+        throw std::runtime_error("Snapshot has a bad stack pointer.");
+    }
+    if (stop_execution_flag > 1 || continue_execution_key > 0xF) {
+        throw std::runtime_error("Snapshot has a bad key wait state.");
+    }
+
+    std::memcpy(interpreter.registers.data(), registers, interpreter.registers.size());
+    for (auto &address : interpreter.stack) {
+        address = get_le(stack, 2);
+    }
+
+    interpreter.stack_pointer = stack_pointer;
+    interpreter.sound_timer = sound_timer;
+    interpreter.delay_timer = delay_timer;
+    interpreter.stop_execution_flag = stop_execution_flag;
+    interpreter.continue_execution_key = continue_execution_key;
+    interpreter.index_register = get_le(in, 2);
+    interpreter.program_counter = get_le(in, 2);
+
+    uint16_t keys = get_le(in, 2);
+    for (size_t key = 0; key < interpreter.keyboard.size(); key++) {
+        interpreter.keyboard[key] = (keys >> key) & 0x1;
+    }
+
+    interpreter.random.restore(get_le(in, 8));
+    interpreter.unknown_opcodes = get_le(in, 8);
+
+    std::array<uint64_t, BaseRender::SCREEN_HEIGHT> rows;
+    for (auto &row : rows) {
+        row = get_le(in, 8);
+    }
+    interpreter.framebuffer->assign(rows);
+
+    uint16_t changed = 0;
+    for (size_t page = 0; page < PAGES; page++) {
+        auto offset = page * PAGE_SIZE;
+        const uint8_t *source = &image[offset];
+        if (pages & (1 << page)) {
+            source = in;
+            in += PAGE_SIZE;
+        }
+
+        if (std::memcmp(&interpreter.memory[offset], source, PAGE_SIZE) != 0) {
+            std::memcpy(&interpreter.memory[offset], source, PAGE_SIZE);
+            changed |= 1 << page;
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,52 @@
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#pragma once
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread. SIZE must
+// be a power of two; push() fails instead of blocking when the queue is full.
+template <typename T, size_t SIZE>
+class SpscQueue {
+public:
+    bool push(const T &item);
+    bool pop(T &item);
+    bool empty() const;
+
+private:
+    static_assert((SIZE & (SIZE - 1)) == 0, "SpscQueue size must be a power of two.");
+
+    std::array<T, SIZE> items;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+template <typename T, size_t SIZE>
+bool SpscQueue<T, SIZE>::push(const T &item) {
+    auto position = tail.load(std::memory_order_relaxed);
+    if (position - head.load(std::memory_order_acquire) == SIZE) {
+        return false;
+    }
+
+    items[position & (SIZE - 1)] = item;
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t SIZE>
+bool SpscQueue<T, SIZE>::pop(T &item) {
+    auto position = head.load(std::memory_order_relaxed);
+    if (position == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    item = items[position & (SIZE - 1)];
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+// Meant for the consumer, which is the only side that can rely on the answer.
+template <typename T, size_t SIZE>
+bool SpscQueue<T, SIZE>::empty() const {
+    return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+}
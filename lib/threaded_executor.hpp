@@ -0,0 +1,649 @@
+#include <array>
+#include <iostream>
+#include <cstring>
+#include "base_interpreter.hpp"
+#include "framebuffer.hpp"
+#include "instruction.hpp"
+#include "decoder.hpp"
+#include "functions.hpp"
+
+#pragma once
+
+#ifndef CHIP8_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define CHIP8_COMPUTED_GOTO 1
+#else
+#define CHIP8_COMPUTED_GOTO 0
+#endif
+#endif
+
+// Alternative execution engine: runs a batch of instructions in one tight loop over its own
+// register file, dispatching directly-threaded through per-address cells (computed goto on
+// GCC/Clang, a table of member function pointers elsewhere). Results match CommandExecutor.
+class ThreadedExecutor {
+public:
+    enum StopReason {
+        BUDGET_EXHAUSTED,
+        DRAW,
+        KEY_WAIT
+    };
+
+    ThreadedExecutor(BaseInterpreter *interpreter);
+
+    StopReason run(uint32_t budget, uint32_t &executed);
+    void invalidate(uint16_t address, uint16_t length);
+
+private:
+    enum Operation : uint8_t {
+        OP_PREDECODE, OP_UNKNOWN,
+        OP_CLS, OP_RET, OP_JP_ADDR, OP_CALL_ADDR, OP_SE_VX_BYTE, OP_SNE_VX_BYTE, OP_SE_VX_VY, OP_LD_VX_BYTE,
+        OP_ADD_VX_BYTE, OP_LD_VX_VY, OP_OR_VX_VY, OP_AND_VX_VY, OP_XOR_VX_VY, OP_ADD_VX_VY_CARRY, OP_SUB_VX_VY,
+        OP_SHR_VX_VY, OP_SUBN_VX_VY, OP_SHL_VX, OP_SNE_VX_VY, OP_LD_I_ADDR, OP_JP_V0_ADDR, OP_RND_VX_BYTE,
+        OP_DRW_VX_VY_N, OP_SKP_VX, OP_SKPN_VX, OP_LD_VX_DT, OP_LD_VX_K, OP_LD_DT_VX, OP_LD_ST_VX, OP_ADD_I_VX,
+        OP_LD_F_VX, OP_LD_B_VX, OP_LD_I_VX, OP_LD_VX_I,
+        OPERATIONS_COUNT
+    };
+
+    struct RegisterFile {
+        std::array<uint8_t, 16> v;
+        uint16_t i;
+        uint16_t pc;
+        uint8_t sp;
+        uint8_t dt;
+        uint8_t st;
+    };
+
+    struct Cell {
+        const void *target;
+        uint16_t opcode;
+        uint16_t nnn;
+        uint8_t operation;
+        uint8_t x;
+        uint8_t y;
+        uint8_t n;
+        uint8_t kk;
+    };
+
+    typedef void (ThreadedExecutor::*Routine)(RegisterFile &r, const Cell &c);
+
+    static const uint16_t ADDRESS_MASK = 0x0FFF;
+    static const uint16_t NEXT_PC = 2;
+    static const uint16_t SKIP_PC = 4;
+
+    BaseInterpreter *interpreter_ptr;
+    const Decoder &decoder = Decoder::instance();
+    const void *const *labels = nullptr;
+
+    std::array<Cell, 4096> cells;
+
+    static Operation operation(const Instruction *instruction);
+    static const std::array<Routine, OPERATIONS_COUNT>& routines();
+
+    StopReason dispatch(uint32_t budget, uint32_t &executed, bool export_labels);
+    void load(RegisterFile &r) const;
+    void store(const RegisterFile &r);
+    void predecode(uint16_t pc);
+
+    void unknown(RegisterFile &r, const Cell &c);
+    void cls(RegisterFile &r, const Cell &c);
+    void ret(RegisterFile &r, const Cell &c);
+    void jp_addr(RegisterFile &r, const Cell &c);
+    void call_addr(RegisterFile &r, const Cell &c);
+    void se_vx_byte(RegisterFile &r, const Cell &c);
+    void sne_vx_byte(RegisterFile &r, const Cell &c);
+    void se_vx_vy(RegisterFile &r, const Cell &c);
+    void ld_vx_byte(RegisterFile &r, const Cell &c);
+    void add_byte(RegisterFile &r, const Cell &c);
+    void ld_vx_vy(RegisterFile &r, const Cell &c);
+    void or_vx_vy(RegisterFile &r, const Cell &c);
+    void and_vx_vy(RegisterFile &r, const Cell &c);
+    void xor_vx_vy(RegisterFile &r, const Cell &c);
+    void add_vx_vy_carry(RegisterFile &r, const Cell &c);
+    void sub_vx_vy(RegisterFile &r, const Cell &c);
+    void shr_vx_vy(RegisterFile &r, const Cell &c);
+    void subn_vx_vy(RegisterFile &r, const Cell &c);
+    void shl_vx(RegisterFile &r, const Cell &c);
+    void sne_vx_vy(RegisterFile &r, const Cell &c);
+    void ld_i_addr(RegisterFile &r, const Cell &c);
+    void jp_v0_addr(RegisterFile &r, const Cell &c);
+    void rnd_vx_byte(RegisterFile &r, const Cell &c);
+    void drw_vx_vy_n(RegisterFile &r, const Cell &c);
+    void skp_vx(RegisterFile &r, const Cell &c);
+    void skpn_vx(RegisterFile &r, const Cell &c);
+    void ld_vx_dt(RegisterFile &r, const Cell &c);
+    void ld_vx_k(RegisterFile &r, const Cell &c);
+    void ld_dt_vx(RegisterFile &r, const Cell &c);
+    void ld_st_vx(RegisterFile &r, const Cell &c);
+    void add_i_vx(RegisterFile &r, const Cell &c);
+    void ld_f_vx(RegisterFile &r, const Cell &c);
+    void ld_b_vx(RegisterFile &r, const Cell &c);
+    void ld_i_vx(RegisterFile &r, const Cell &c);
+    void ld_vx_i(RegisterFile &r, const Cell &c);
+};
+
+ThreadedExecutor::ThreadedExecutor(BaseInterpreter *interpreter) : interpreter_ptr(interpreter) {
+    uint32_t executed = 0;
+    dispatch(0, executed, true);
+    invalidate(0, cells.size());
+}
+
+ThreadedExecutor::StopReason ThreadedExecutor::run(uint32_t budget, uint32_t &executed) {
+    return dispatch(budget, executed, false);
+}
+
+void ThreadedExecutor::invalidate(uint16_t address, uint16_t length) {
+    Cell cell = {labels != nullptr ? labels[OP_PREDECODE] : nullptr, 0, 0, OP_PREDECODE, 0, 0, 0, 0};
+
+    for (uint32_t i = 0; i <= length; i++) {
+        cells[(address + i - 1) & ADDRESS_MASK] = cell;
+    }
+}
+
+ThreadedExecutor::Operation ThreadedExecutor::operation(const Instruction *instruction) {
+    if (instruction == nullptr) {
+        return OP_UNKNOWN;
+    }
+
+    switch (*instruction) {
+        case ::CLS:
+            return OP_CLS;
+        case ::RET:
+            return OP_RET;
+        case ::JP_ADDR:
+            return OP_JP_ADDR;
+        case ::CALL_ADDR:
+            return OP_CALL_ADDR;
+        case ::SE_VX_BYTE:
+            return OP_SE_VX_BYTE;
+        case ::SNE_VX_BYTE:
+            return OP_SNE_VX_BYTE;
+        case ::SE_VX_VY:
+            return OP_SE_VX_VY;
+        case ::LD_VX_BYTE:
+            return OP_LD_VX_BYTE;
+        case ::ADD_VX_BYTE:
+            return OP_ADD_VX_BYTE;
+        case ::LD_VX_VY:
+            return OP_LD_VX_VY;
+        case ::OR_VX_VY:
+            return OP_OR_VX_VY;
+        case ::AND_VX_VY:
+            return OP_AND_VX_VY;
+        case ::XOR_VX_VY:
+            return OP_XOR_VX_VY;
+        case ::ADD_VX_VY_CARRY:
+            return OP_ADD_VX_VY_CARRY;
+        case ::SUB_VX_VY:
+            return OP_SUB_VX_VY;
+        case ::SHR_VX_VY:
+            return OP_SHR_VX_VY;
+        case ::SUBN_VX_VY:
+            return OP_SUBN_VX_VY;
+        case ::SHL_VX:
+            return OP_SHL_VX;
+        case ::SNE_VX_VY:
+            return OP_SNE_VX_VY;
+        case ::LD_I_ADDR:
+            return OP_LD_I_ADDR;
+        case ::JP_V0_ADDR:
+            return OP_JP_V0_ADDR;
+        case ::RND_VX_BYTE:
+            return OP_RND_VX_BYTE;
+        case ::DRW_VX_VY_N:
+            return OP_DRW_VX_VY_N;
+        case ::SKP_VX:
+            return OP_SKP_VX;
+        case ::SKPN_VX:
+            return OP_SKPN_VX;
+        case ::LD_VX_DT:
+            return OP_LD_VX_DT;
+        case ::LD_VX_K:
+            return OP_LD_VX_K;
+        case ::LD_DT_VX:
+            return OP_LD_DT_VX;
+        case ::LD_ST_VX:
+            return OP_LD_ST_VX;
+        case ::ADD_I_VX:
+            return OP_ADD_I_VX;
+        case ::LD_F_VX:
+            return OP_LD_F_VX;
+        case ::LD_B_VX:
+            return OP_LD_B_VX;
+        case ::LD_I_VX:
+            return OP_LD_I_VX;
+        case ::LD_VX_I:
+            return OP_LD_VX_I;
+    }
+
+    return OP_UNKNOWN;
+}
+
+const std::array<ThreadedExecutor::Routine, ThreadedExecutor::OPERATIONS_COUNT>& ThreadedExecutor::routines() {
+    static const std::array<Routine, OPERATIONS_COUNT> table = {
+        nullptr, &ThreadedExecutor::unknown,
+        &ThreadedExecutor::cls, &ThreadedExecutor::ret, &ThreadedExecutor::jp_addr, &ThreadedExecutor::call_addr,
+        &ThreadedExecutor::se_vx_byte, &ThreadedExecutor::sne_vx_byte, &ThreadedExecutor::se_vx_vy,
+        &ThreadedExecutor::ld_vx_byte, &ThreadedExecutor::add_byte, &ThreadedExecutor::ld_vx_vy,
+        &ThreadedExecutor::or_vx_vy, &ThreadedExecutor::and_vx_vy, &ThreadedExecutor::xor_vx_vy,
+        &ThreadedExecutor::add_vx_vy_carry, &ThreadedExecutor::sub_vx_vy, &ThreadedExecutor::shr_vx_vy,
+        &ThreadedExecutor::subn_vx_vy, &ThreadedExecutor::shl_vx, &ThreadedExecutor::sne_vx_vy,
+        &ThreadedExecutor::ld_i_addr, &ThreadedExecutor::jp_v0_addr, &ThreadedExecutor::rnd_vx_byte,
+        &ThreadedExecutor::drw_vx_vy_n, &ThreadedExecutor::skp_vx, &ThreadedExecutor::skpn_vx,
+        &ThreadedExecutor::ld_vx_dt, &ThreadedExecutor::ld_vx_k, &ThreadedExecutor::ld_dt_vx,
+        &ThreadedExecutor::ld_st_vx, &ThreadedExecutor::add_i_vx, &ThreadedExecutor::ld_f_vx,
+        &ThreadedExecutor::ld_b_vx, &ThreadedExecutor::ld_i_vx, &ThreadedExecutor::ld_vx_i
+    };
+
+    return table;
+}
+
+#if CHIP8_COMPUTED_GOTO
+
+ThreadedExecutor::StopReason ThreadedExecutor::dispatch(uint32_t budget, uint32_t &executed, bool export_labels) {
+    static const void *const targets[OPERATIONS_COUNT] = {
+        &&predecode, &&unknown,
+        &&cls, &&ret, &&jp_addr, &&call_addr, &&se_vx_byte, &&sne_vx_byte, &&se_vx_vy, &&ld_vx_byte,
+        &&add_byte, &&ld_vx_vy, &&or_vx_vy, &&and_vx_vy, &&xor_vx_vy, &&add_vx_vy_carry, &&sub_vx_vy,
+        &&shr_vx_vy, &&subn_vx_vy, &&shl_vx, &&sne_vx_vy, &&ld_i_addr, &&jp_v0_addr, &&rnd_vx_byte,
+        &&drw_vx_vy_n, &&skp_vx, &&skpn_vx, &&ld_vx_dt, &&ld_vx_k, &&ld_dt_vx, &&ld_st_vx, &&add_i_vx,
+        &&ld_f_vx, &&ld_b_vx, &&ld_i_vx, &&ld_vx_i
+    };
+
+    executed = 0;
+    if (export_labels) {
+        labels = targets;
+        return BUDGET_EXHAUSTED;
+    }
+    if (interpreter_ptr->stop_execution_flag == 0x1) {
+        return KEY_WAIT;
+    }
+
+    RegisterFile r;
+    const Cell *cell;
+    StopReason reason = BUDGET_EXHAUSTED;
+    load(r);
+
+#define NEXT() \
+    if (executed == budget) goto exit; \
+    executed++; \
+    cell = &cells[r.pc & ADDRESS_MASK]; \
+    goto *cell->target
+
+#define OPERATION(name) \
+    name: \
+    name(r, *cell); \
+    NEXT()
+
+#define STOPPING_OPERATION(name, stop_reason) \
+    name: \
+    name(r, *cell); \
+    reason = stop_reason; \
+    goto exit
+
+    NEXT();
+
+    predecode:
+    predecode(r.pc);
+    cell = &cells[r.pc & ADDRESS_MASK];
+    goto *cell->target;
+
+    OPERATION(unknown);
+    STOPPING_OPERATION(cls, DRAW);
+    OPERATION(ret);
+    OPERATION(jp_addr);
+    OPERATION(call_addr);
+    OPERATION(se_vx_byte);
+    OPERATION(sne_vx_byte);
+    OPERATION(se_vx_vy);
+    OPERATION(ld_vx_byte);
+    OPERATION(add_byte);
+    OPERATION(ld_vx_vy);
+    OPERATION(or_vx_vy);
+    OPERATION(and_vx_vy);
+    OPERATION(xor_vx_vy);
+    OPERATION(add_vx_vy_carry);
+    OPERATION(sub_vx_vy);
+    OPERATION(shr_vx_vy);
+    OPERATION(subn_vx_vy);
+    OPERATION(shl_vx);
+    OPERATION(sne_vx_vy);
+    OPERATION(ld_i_addr);
+    OPERATION(jp_v0_addr);
+    OPERATION(rnd_vx_byte);
+    STOPPING_OPERATION(drw_vx_vy_n, DRAW);
+    OPERATION(skp_vx);
+    OPERATION(skpn_vx);
+    OPERATION(ld_vx_dt);
+    STOPPING_OPERATION(ld_vx_k, KEY_WAIT);
+    OPERATION(ld_dt_vx);
+    OPERATION(ld_st_vx);
+    OPERATION(add_i_vx);
+    OPERATION(ld_f_vx);
+    OPERATION(ld_b_vx);
+    OPERATION(ld_i_vx);
+    OPERATION(ld_vx_i);
+
+#undef STOPPING_OPERATION
+#undef OPERATION
+#undef NEXT
+
+    exit:
+    store(r);
+    return reason;
+}
+
+#else
+
+ThreadedExecutor::StopReason ThreadedExecutor::dispatch(uint32_t budget, uint32_t &executed, bool export_labels) {
+    executed = 0;
+    if (export_labels || interpreter_ptr->stop_execution_flag == 0x1) {
+        return export_labels ? BUDGET_EXHAUSTED : KEY_WAIT;
+    }
+
+    auto &table = routines();
+    RegisterFile r;
+    StopReason reason = BUDGET_EXHAUSTED;
+    load(r);
+
+    while (executed < budget) {
+        auto *cell = &cells[r.pc & ADDRESS_MASK];
+        if (cell->operation == OP_PREDECODE) {
+            predecode(r.pc);
+        }
+
+        auto operation = cell->operation;
+        (this->*table[operation])(r, *cell);
+        executed++;
+
+        if (operation == OP_CLS || operation == OP_DRW_VX_VY_N) {
+            reason = DRAW;
+            break;
+        }
+        if (operation == OP_LD_VX_K) {
+            reason = KEY_WAIT;
+            break;
+        }
+    }
+
+    store(r);
+    return reason;
+}
+
+#endif
+
+void ThreadedExecutor::load(RegisterFile &r) const {
+    r.v = interpreter_ptr->registers;
+    r.i = interpreter_ptr->index_register;
+    r.pc = interpreter_ptr->program_counter;
+    r.sp = interpreter_ptr->stack_pointer;
+    r.dt = interpreter_ptr->delay_timer;
+    r.st = interpreter_ptr->sound_timer;
+}
+
+void ThreadedExecutor::store(const RegisterFile &r) {
+    interpreter_ptr->registers = r.v;
+    interpreter_ptr->index_register = r.i;
+    interpreter_ptr->program_counter = r.pc;
+    interpreter_ptr->stack_pointer = r.sp;
+    interpreter_ptr->delay_timer = r.dt;
+    interpreter_ptr->sound_timer = r.st;
+}
+
+void ThreadedExecutor::predecode(uint16_t pc) {
+    pc &= ADDRESS_MASK;
+    uint16_t opcode = interpreter_ptr->memory[pc] << 8 | interpreter_ptr->memory[(pc + 1) & ADDRESS_MASK];
+    auto operation = ThreadedExecutor::operation(decoder.decode(opcode));
+
+    cells[pc] = {
+        labels != nullptr ? labels[operation] : nullptr,
+        opcode,
+        static_cast<uint16_t>(opcode & 0x0FFF),
+        operation,
+        static_cast<uint8_t>((opcode & 0x0F00) >> 8),
+        static_cast<uint8_t>((opcode & 0x00F0) >> 4),
+        static_cast<uint8_t>(opcode & 0x000F),
+        static_cast<uint8_t>(opcode & 0x00FF)
+    };
+}
+
+void ThreadedExecutor::unknown(RegisterFile &, const Cell &c) {
+    interpreter_ptr->unknown_opcodes++;
+
+    if (interpreter_ptr->log != nullptr) {
+        *interpreter_ptr->log << "Unknown opcode " << to_hex(c.opcode) << std::endl;
+    }
+}
+
+// 0x00E0
+void ThreadedExecutor::cls(RegisterFile &r, const Cell &) {
+    interpreter_ptr->framebuffer->clean();
+    r.pc += NEXT_PC;
+}
+
+// 0x00EE
+void ThreadedExecutor::ret(RegisterFile &r, const Cell &) {
+    r.pc = interpreter_ptr->stack[--r.sp];
+}
+
+// 0x1nnn
+void ThreadedExecutor::jp_addr(RegisterFile &r, const Cell &c) {
+    r.pc = c.nnn;
+}
+
+// 0x2nnn
+void ThreadedExecutor::call_addr(RegisterFile &r, const Cell &c) {
+    interpreter_ptr->stack[r.sp++] = r.pc + 2;
+    r.pc = c.nnn;
+}
+
+// 0x3xkk
+void ThreadedExecutor::se_vx_byte(RegisterFile &r, const Cell &c) {
+    r.pc += r.v[c.x] == c.kk ? SKIP_PC : NEXT_PC;
+}
+
+// 0x4xkk
+void ThreadedExecutor::sne_vx_byte(RegisterFile &r, const Cell &c) {
+    r.pc += r.v[c.x] != c.kk ? SKIP_PC : NEXT_PC;
+}
+
+// 0x5xy0
+void ThreadedExecutor::se_vx_vy(RegisterFile &r, const Cell &c) {
+    r.pc += r.v[c.x] == r.v[c.y] ? SKIP_PC : NEXT_PC;
+}
+
+// 0x6xkk
+void ThreadedExecutor::ld_vx_byte(RegisterFile &r, const Cell &c) {
+    r.v[c.x] = c.kk;
+    r.pc += NEXT_PC;
+}
+
+// 0x7xkk
+void ThreadedExecutor::add_byte(RegisterFile &r, const Cell &c) {
+    r.v[c.x] += c.kk;
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy0
+void ThreadedExecutor::ld_vx_vy(RegisterFile &r, const Cell &c) {
+    r.v[c.x] = r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy1
+void ThreadedExecutor::or_vx_vy(RegisterFile &r, const Cell &c) {
+    r.v[c.x] |= r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy2
+void ThreadedExecutor::and_vx_vy(RegisterFile &r, const Cell &c) {
+    r.v[c.x] &= r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy3
+void ThreadedExecutor::xor_vx_vy(RegisterFile &r, const Cell &c) {
+    r.v[c.x] ^= r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy4
+void ThreadedExecutor::add_vx_vy_carry(RegisterFile &r, const Cell &c) {
+    uint8_t vx = r.v[c.x];
+    uint8_t vy = r.v[c.y];
+
+    r.v[0xF] = vy > (0xFF - vx) ? 1 : 0;
+    r.v[c.x] += r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy5
+void ThreadedExecutor::sub_vx_vy(RegisterFile &r, const Cell &c) {
+    uint8_t vx = r.v[c.x];
+    uint8_t vy = r.v[c.y];
+
+    r.v[0xF] = vx > vy ? 1 : 0;
+    r.v[c.x] -= r.v[c.y];
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy6
+void ThreadedExecutor::shr_vx_vy(RegisterFile &r, const Cell &c) {
+    r.v[0xF] = r.v[c.x] & 0x1;
+    r.v[c.x] >>= 1;
+    r.pc += NEXT_PC;
+}
+
+// 0x8xy7
+void ThreadedExecutor::subn_vx_vy(RegisterFile &r, const Cell &c) {
+    uint8_t vx = r.v[c.x];
+    uint8_t vy = r.v[c.y];
+
+    r.v[0xF] = vy > vx ? 1 : 0;
+    r.v[c.x] = vy - vx;
+    r.pc += NEXT_PC;
+}
+
+// 0x8xyE
+void ThreadedExecutor::shl_vx(RegisterFile &r, const Cell &c) {
+    r.v[0xF] = r.v[c.x] >> 7;
+    r.v[c.x] <<= 1;
+    r.pc += NEXT_PC;
+}
+
+// 0x9xy0
+void ThreadedExecutor::sne_vx_vy(RegisterFile &r, const Cell &c) {
+    r.pc += r.v[c.x] != r.v[c.y] ? SKIP_PC : NEXT_PC;
+}
+
+// 0xAnnn
+void ThreadedExecutor::ld_i_addr(RegisterFile &r, const Cell &c) {
+    r.i = c.nnn;
+    r.pc += NEXT_PC;
+}
+
+// 0xBnnn
+void ThreadedExecutor::jp_v0_addr(RegisterFile &r, const Cell &c) {
+    r.pc = c.nnn + r.v[0x0];
+}
+
+// 0xCxkk
+void ThreadedExecutor::rnd_vx_byte(RegisterFile &r, const Cell &c) {
+    uint8_t rnd = interpreter_ptr->random.next_byte();
+
+    r.v[c.x] = rnd & c.kk;
+    r.pc += NEXT_PC;
+}
+
+// 0xDxyn
+void ThreadedExecutor::drw_vx_vy_n(RegisterFile &r, const Cell &c) {
+    auto memory = &interpreter_ptr->memory[r.i];
+
+    r.v[0xF] = interpreter_ptr->framebuffer->draw(memory, c.n, r.v[c.x], r.v[c.y]);
+    r.pc += NEXT_PC;
+}
+
+// 0xEx9E
+void ThreadedExecutor::skp_vx(RegisterFile &r, const Cell &c) {
+    r.pc += interpreter_ptr->keyboard[r.v[c.x] & 0xF] ? SKIP_PC : NEXT_PC;
+}
+
+// 0xExA1
+void ThreadedExecutor::skpn_vx(RegisterFile &r, const Cell &c) {
+    r.pc += !interpreter_ptr->keyboard[r.v[c.x] & 0xF] ? SKIP_PC : NEXT_PC;
+}
+
+// 0xFx07
+void ThreadedExecutor::ld_vx_dt(RegisterFile &r, const Cell &c) {
+    r.v[c.x] = r.dt;
+    r.pc += NEXT_PC;
+}
+
+// 0xFx0A
+void ThreadedExecutor::ld_vx_k(RegisterFile &r, const Cell &c) {
+    interpreter_ptr->stop_execution_flag = 0x1;
+    interpreter_ptr->continue_execution_key = c.x;
+    r.pc += NEXT_PC;
+}
+
+// 0xFx15
+void ThreadedExecutor::ld_dt_vx(RegisterFile &r, const Cell &c) {
+    r.dt = r.v[c.x];
+    r.pc += NEXT_PC;
+}
+
+// 0xFx18
+void ThreadedExecutor::ld_st_vx(RegisterFile &r, const Cell &c) {
+    r.st = r.v[c.x];
+    r.pc += NEXT_PC;
+}
+
+// 0xFx1E
+void ThreadedExecutor::add_i_vx(RegisterFile &r, const Cell &c) {
+    uint8_t vx = r.v[c.x];
+
+    r.v[0xF] = r.i + vx > 0x0FFF ? 1 : 0;
+    r.i += vx;
+    r.pc += NEXT_PC;
+}
+
+// 0xFx29
+void ThreadedExecutor::ld_f_vx(RegisterFile &r, const Cell &c) {
+    r.i = r.v[c.x] * 5;
+    r.pc += NEXT_PC;
+}
+
+// 0xFx33
+void ThreadedExecutor::ld_b_vx(RegisterFile &r, const Cell &c) {
+    uint8_t vx = r.v[c.x];
+    uint16_t index = r.i;
+
+    interpreter_ptr->memory[index] = vx / 100;
+    interpreter_ptr->memory[index + 1] = (vx / 10) % 10;
+    interpreter_ptr->memory[index + 2] = (vx % 100) % 10;
+    invalidate(index, 3);
+    r.pc += NEXT_PC;
+}
+
+// 0xFx55
+void ThreadedExecutor::ld_i_vx(RegisterFile &r, const Cell &c) {
+    uint8_t x = c.x;
+    uint16_t index = r.i;
+
+    std::memcpy(&interpreter_ptr->memory[index], &r.v[0], x + 1);
+    invalidate(index, x + 1);
+
+    r.i += x + 1;
+    r.pc += NEXT_PC;
+}
+
+// 0xFx65
+void ThreadedExecutor::ld_vx_i(RegisterFile &r, const Cell &c) {
+    uint8_t x = c.x;
+    uint16_t index = r.i;
+
+    std::memcpy(&r.v[0], &interpreter_ptr->memory[index], x + 1);
+
+    r.i += x + 1;
+    r.pc += NEXT_PC;
+}
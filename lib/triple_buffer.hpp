@@ -0,0 +1,60 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#pragma once
+
+// Lock-free handoff of the newest value from one writer thread to one reader thread. The writer
+// fills back() and publishes it; the reader picks up the newest published value with update()
+// and reads it through front(). Values published in between are dropped.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer(const T &initial = T());
+
+    T& back();
+    void publish();
+
+    bool update();
+    const T& front() const;
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;
+
+    std::array<T, 3> slots;
+    alignas(64) uint8_t back_index = 0;
+    alignas(64) uint8_t front_index = 1;
+    alignas(64) std::atomic<uint8_t> middle{2};
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer(const T &initial) {
+    slots.fill(initial);
+}
+
+template <typename T>
+T& TripleBuffer<T>::back() {
+    return slots[back_index];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish() {
+    back_index = middle.exchange(back_index | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+// Returns whether front() changed since the last call.
+template <typename T>
+bool TripleBuffer<T>::update() {
+    if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+        return false;
+    }
+
+    front_index = middle.exchange(front_index, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::front() const {
+    return slots[front_index];
+}
@@ -0,0 +1,99 @@
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#pragma once
+
+// Runs a batch of independent tasks on a fixed number of threads. Tasks are dealt round-robin
+// into per-thread deques; a thread takes from the back of its own deque and, once that is
+// empty, steals from the front of the others, so long tasks don't leave threads idle. Each
+// deque has its own lock, taken once per task, which is noise next to an emulator run.
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    WorkStealingPool(unsigned threads = std::thread::hardware_concurrency());
+
+    unsigned threads_count() const;
+    void run(std::vector<Task> &&tasks);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    unsigned threads;
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    bool pop(unsigned index, Task &task);
+    bool steal(unsigned index, Task &task);
+    void work(unsigned index);
+};
+
+WorkStealingPool::WorkStealingPool(unsigned threads) : threads(threads == 0 ? 1 : threads) {
+    for (unsigned i = 0; i < this->threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+unsigned WorkStealingPool::threads_count() const {
+    return threads;
+}
+
+// Returns once every task has finished; the calling thread works as one of the threads.
+void WorkStealingPool::run(std::vector<Task> &&tasks) {
+    for (size_t i = 0; i < tasks.size(); i++) {
+        queues[i % threads]->tasks.push_back(std::move(tasks[i]));
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::work, this, i);
+    }
+    work(0);
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+bool WorkStealingPool::pop(unsigned index, Task &task) {
+    auto &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned index, Task &task) {
+    for (unsigned offset = 1; offset < threads; offset++) {
+        auto &queue = *queues[(index + offset) % threads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// No task adds new ones, so a thread that finds every deque empty is done.
+void WorkStealingPool::work(unsigned index) {
+    Task task;
+
+    while (pop(index, task) || steal(index, task)) {
+        task();
+    }
+}
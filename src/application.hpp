@@ -1,18 +1,60 @@
 #include <string>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include "lib/interpreter.hpp"
+#include "lib/scheduler.hpp"
+#include "lib/rewind.hpp"
+#include "lib/movie.hpp"
+#include "lib/opcode_stats.hpp"
+#include "lib/exchange_render.hpp"
+#include "lib/spsc_queue.hpp"
+#include "render.hpp"
+#include "options.hpp"
 
+// The SDL thread only polls input and presents; the interpreter runs on an emulation thread.
+// Screens travel through ExchangeRender and key events through a queue, so neither side locks.
+// Holding Backspace plays the captured frames backwards, except while a movie is recorded
+// (--record) or played (--play): movies are keyed by frame number, so their runs only go forward.
+// A playing movie replaces the keyboard until its last key event.
+// While the guest waits on Fx0A with both timers stopped, no frame can change anything, so the
+// emulation thread sleeps until a key event arrives and the SDL thread blocks on SDL events.
 class Application {
 private:
-    static const int CPU_TICK = 16;
-    static const int CPU_UPDATE_RATE = 500;
+    static const uint8_t REWIND_KEY = 0xFF;
+    static const Uint32 PARKED_WAIT_MILLISECONDS = 100;
+
+    struct KeyEvent {
+        uint8_t code;
+        bool is_pressed;
+    };
 
     std::unique_ptr<Interpreter> interpreter_ptr;
+    std::unique_ptr<Scheduler> scheduler_ptr;
+    std::unique_ptr<Rewind> rewind_ptr;
+    std::unique_ptr<Movie> movie_ptr;
+    std::unique_ptr<MoviePlayer> player_ptr;
+    std::unique_ptr<OpcodeStats> opcode_stats_ptr;
+    OpcodeStats::Format opcode_stats_format;
+    std::unique_ptr<Profiler> profiler_ptr;
+    std::string profile_path;
+    std::string record_path;
+    std::string save_state_path;
     std::unique_ptr<Render> render_ptr;
+    std::unique_ptr<ExchangeRender> exchange_ptr;
     std::unique_ptr<Framebuffer> framebuffer_ptr;
 
-    bool is_running = true;
-    Uint32 last_update_frame;
+    std::atomic<bool> is_running{true};
+    std::atomic<bool> is_parked{false};
+    std::mutex park_mutex;
+    std::condition_variable park_condition;
+    bool is_rewinding = false;
+    std::thread emulation_thread;
+    std::exception_ptr emulation_error;
+    SpscQueue<KeyEvent, 64> key_events;
 
     std::map<SDL_Keycode, uint8_t> keyboard = {
         {SDLK_1, 0x1}, {SDLK_2, 0x2}, {SDLK_3, 0x3}, {SDLK_4, 0xC},
@@ -21,82 +63,278 @@ private:
         {SDLK_z, 0xA}, {SDLK_x, 0x0}, {SDLK_c, 0xB}, {SDLK_v, 0xF}
     };
 
+    void emulate();
+    void handle_key_events();
+    bool is_waiting_for_key() const;
+    void park();
+    void unpark();
+    void wake();
+    void queue_key_event(KeyEvent event);
+    void save_movie();
     void handle(SDL_Event &event);
-    void execute_opcode();
+    void wait_until(Uint64 deadline);
     void quit_event();
     void keyboard_down_event(SDL_KeyboardEvent &event);
     void keyboard_up_event(SDL_KeyboardEvent &event);
 public:
-    Application(std::string &&filename);
+    Application(Options &&options);
 
     const int run();
 };
 
-Application::Application(std::string &&filename) {
+Application::Application(Options &&options) :
+        opcode_stats_format(options.opcode_stats_format), profile_path(options.profile_path),
+        record_path(options.record_path), save_state_path(options.save_state_path) {
+    if (!options.record_path.empty() && !options.play_path.empty()) {
+        throw std::runtime_error("Only one of --record and --play can be used.");
+    }
+    if (!options.play_path.empty()) {
+        movie_ptr = std::make_unique<Movie>(Movie::load(options.play_path));
+        player_ptr = std::make_unique<MoviePlayer>(movie_ptr->events);
+        apply_movie(options, *movie_ptr);
+    }
+    if (!options.record_path.empty()) {
+        movie_ptr = std::make_unique<Movie>();
+        movie_ptr->rom_hash = rom_hash(read_file(options.filename));
+        movie_ptr->seed = options.seed;
+        movie_ptr->instructions_per_second = options.instructions_per_second;
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         throw std::runtime_error("SDL can't initialize.");
     }
 
-    render_ptr = std::make_unique<Render>();
-    framebuffer_ptr = std::make_unique<Framebuffer>(render_ptr.get());
+    render_ptr = std::make_unique<Render>(options.vsync);
+    exchange_ptr = std::make_unique<ExchangeRender>();
+    framebuffer_ptr = std::make_unique<Framebuffer>(exchange_ptr.get());
+    framebuffer_ptr->set_present_mode(options.present_mode);
     interpreter_ptr = std::make_unique<Interpreter>(framebuffer_ptr.get());
 
-    interpreter_ptr->load(std::move(filename));
+    interpreter_ptr->random.seed(options.seed);
+    interpreter_ptr->set_engine(options.engine);
+    if (options.lockstep) {
+        interpreter_ptr->set_lockstep(true);
+    }
+    interpreter_ptr->load(read_file(options.filename));
+    if (!options.load_state_path.empty()) {
+        interpreter_ptr->load_snapshot(options.load_state_path);
+    }
+
+    scheduler_ptr = std::make_unique<Scheduler>(interpreter_ptr.get(), options.instructions_per_second);
+    scheduler_ptr->set_idle_skipping(options.idle_skipping);
+    opcode_stats_ptr = attach_opcode_stats(options, *interpreter_ptr);
+    if (!profile_path.empty()) {
+        profiler_ptr = std::make_unique<Profiler>();
+        scheduler_ptr->set_profiler(profiler_ptr.get());
+    }
+    rewind_ptr = std::make_unique<Rewind>(interpreter_ptr.get());
 }
 
+// Presents every new screen whole, so screens the emulation published in between aren't lost.
 const int Application::run() {
     SDL_Event event;
 
-    while (is_running) {
-        auto begin_frame = SDL_GetTicks();
+    DirtyRegion everything;
+    everything.add(0xFFFFFFFF, 0, BaseRender::SCREEN_WIDTH);
+
+    emulation_thread = std::thread(&Application::emulate, this);
 
+    while (is_running) {
         while (SDL_PollEvent(&event)) {
             handle(event);
         }
 
-        if (!interpreter_ptr->is_stop_execution()) {
-            execute_opcode();
-        }
-
-        auto end_frame = SDL_GetTicks();
-        if (end_frame - begin_frame < 1000 / CPU_UPDATE_RATE) {
-            SDL_Delay(1000 / CPU_UPDATE_RATE - (end_frame - begin_frame));
+        auto frame = exchange_ptr->acquire();
+        if (frame != nullptr) {
+            render_ptr->draw(*frame, everything);
+        } else if (is_parked) {
+            if (SDL_WaitEventTimeout(&event, PARKED_WAIT_MILLISECONDS)) {
+                handle(event);
+            }
+        } else {
+            SDL_Delay(1);
         }
     }
+
+    emulation_thread.join();
     
     SDL_Quit();
+
+    if (!record_path.empty()) {
+        save_movie();
+    }
+    if (!save_state_path.empty()) {
+        interpreter_ptr->save_snapshot(save_state_path);
+    }
+    if (opcode_stats_ptr) {
+        opcode_stats_ptr->print(std::cerr, opcode_stats_format);
+    }
+    if (profiler_ptr) {
+        profiler_ptr->save(profile_path);
+    }
+
+    if (emulation_error) {
+        std::rethrow_exception(emulation_error);
+    }
     
     return 0;
 }
 
-void Application::handle(SDL_Event &event) {
-    if (event.type == SDL_QUIT) {
-        quit_event();
-    } else if (event.type == SDL_KEYDOWN) {
-        keyboard_down_event(event.key);
-    } else if (event.type == SDL_KEYUP) {
-        keyboard_up_event(event.key);
+// Paces emulated frames against the high resolution counter. Deadlines are derived from the frame
+// number rather than accumulated, so they don't drift; after a long stall or a park the schedule
+// restarts instead of running a burst of frames to catch up. Frames slept through while parked
+// are not counted, which movies don't notice: they are stamped with the frames that ran.
+void Application::emulate() {
+    auto frequency = SDL_GetPerformanceFrequency();
+    auto start = SDL_GetPerformanceCounter();
+    Uint64 frame = 0;
+
+    try {
+        while (is_running) {
+            handle_key_events();
+
+            if (is_rewinding) {
+                rewind_ptr->step_back();
+                framebuffer_ptr->present();
+            } else {
+                if (player_ptr) {
+                    player_ptr->apply(scheduler_ptr->frames(), *interpreter_ptr);
+                }
+                scheduler_ptr->run_frame();
+                rewind_ptr->capture();
+            }
+            frame++;
+
+            if (is_parked) {
+                unpark();
+            }
+
+            if (opcode_stats_ptr && OpcodeStats::take_dump_request()) {
+                opcode_stats_ptr->print(std::cerr, opcode_stats_format);
+            }
+
+            if (is_waiting_for_key()) {
+                park();
+                start = SDL_GetPerformanceCounter();
+                frame = 0;
+                continue;
+            }
+
+            auto deadline = start + frame * frequency / Scheduler::FRAME_RATE;
+            auto now = SDL_GetPerformanceCounter();
+            if (now > deadline + frequency / 4) {
+                start = now;
+                frame = 0;
+                continue;
+            }
+
+            wait_until(deadline);
+        }
+    } catch (...) {
+        emulation_error = std::current_exception();
+        is_running = false;
     }
 }
 
-void Application::execute_opcode() {
-    auto current_frame = SDL_GetTicks();
+// Key events are stamped with the frame they are applied before, as a movie replays them.
+void Application::handle_key_events() {
+    KeyEvent event;
 
-    if (current_frame - last_update_frame < CPU_TICK) {
-        return;
+    while (key_events.pop(event)) {
+        if (event.code == REWIND_KEY) {
+            is_rewinding = event.is_pressed && !movie_ptr;
+            continue;
+        }
+        if (player_ptr && !player_ptr->is_finished()) {
+            continue;
+        }
+        if (!record_path.empty()) {
+            movie_ptr->events.push_back({scheduler_ptr->frames(), event.code, event.is_pressed});
+        }
+
+        if (event.is_pressed) {
+            interpreter_ptr->key_pressed(event.code);
+        } else {
+            interpreter_ptr->key_released(event.code);
+        }
     }
-    interpreter_ptr->update_timers();
+}
+
+// A movie still playing presses keys on its own frames, so those must keep running.
+bool Application::is_waiting_for_key() const {
+    return interpreter_ptr->is_stop_execution() && interpreter_ptr->delay_timer == 0 &&
+           interpreter_ptr->sound_timer == 0 && !is_rewinding && (!player_ptr || player_ptr->is_finished());
+}
+
+// The fences pair with the one in queue_key_event: either the SDL thread sees is_parked and
+// notifies, or this thread sees the event and doesn't sleep.
+void Application::park() {
+    std::unique_lock<std::mutex> lock(park_mutex);
+    is_parked = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    park_condition.wait(lock, [this] { return !key_events.empty() || !is_running; });
+}
 
-    auto opcode = interpreter_ptr->fetch_opcode();
-    auto instruction = interpreter_ptr->decode(opcode);
+// Called once the first frame after a park is published. Until then the SDL thread keeps
+// waiting on events, and the event pushed here wakes it to draw that frame right away.
+void Application::unpark() {
+    is_parked = false;
 
-    interpreter_ptr->execute(instruction, opcode);
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    SDL_PushEvent(&event);
+}
+
+void Application::wake() {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    park_condition.notify_one();
+}
+
+// Running frames never lock; only a parked emulation thread is woken through the mutex. Events
+// are never dropped, since a lost release leaves a key or rewind held down: a full queue is
+// drained within a frame, and until then this waits for room.
+void Application::queue_key_event(KeyEvent event) {
+    while (!key_events.push(event)) {
+        if (!is_running) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    last_update_frame = SDL_GetTicks();
+    if (is_parked) {
+        wake();
+    }
+}
+
+void Application::save_movie() {
+    movie_ptr->frames = scheduler_ptr->frames();
+    movie_ptr->save(record_path);
+}
+
+void Application::wait_until(Uint64 deadline) {
+    auto frequency = SDL_GetPerformanceFrequency();
+
+    for (auto now = SDL_GetPerformanceCounter(); now < deadline; now = SDL_GetPerformanceCounter()) {
+        auto milliseconds = (deadline - now) * 1000 / frequency;
+        SDL_Delay(milliseconds > 1 ? milliseconds - 1 : 0);
+    }
+}
+
+void Application::handle(SDL_Event &event) {
+    if (event.type == SDL_QUIT) {
+        quit_event();
+    } else if (event.type == SDL_KEYDOWN) {
+        keyboard_down_event(event.key);
+    } else if (event.type == SDL_KEYUP) {
+        keyboard_up_event(event.key);
+    }
 }
 
 void Application::quit_event() {
     is_running = false;
+    wake();
 }
 
 void Application::keyboard_down_event(SDL_KeyboardEvent &event) {
@@ -107,20 +345,30 @@ void Application::keyboard_down_event(SDL_KeyboardEvent &event) {
         return;
     }
 
+    if (keycode == SDLK_BACKSPACE) {
+        queue_key_event({REWIND_KEY, true});
+        return;
+    }
+
     if (keyboard.find(keycode) == keyboard.end()) {
         return;
     }
 
-    interpreter_ptr->key_pressed(keyboard[keycode]);
+    queue_key_event({keyboard[keycode], true});
 }
 
 void Application::keyboard_up_event(SDL_KeyboardEvent &event) {
     auto keycode = event.keysym.sym;
 
+    if (keycode == SDLK_BACKSPACE) {
+        queue_key_event({REWIND_KEY, false});
+        return;
+    }
+
     if (keyboard.find(keycode) == keyboard.end()) {
         return;
     }
 
-    interpreter_ptr->key_released(keyboard[keycode]);
+    queue_key_event({keyboard[keycode], false});
 }
 
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <iostream>
+#include "lib/interpreter.hpp"
+#include "lib/scheduler.hpp"
+#include "lib/null_render.hpp"
+#include "lib/image_render.hpp"
+#include "lib/hash_render.hpp"
+#include "lib/opcode_stats.hpp"
+#include "lib/file.hpp"
+#include "options.hpp"
+
+#pragma once
+
+// Runs a ROM without SDL as fast as the host allows, for a number of instructions (--cycles) or
+// frames (--frames), and prints a summary. The timers still tick once per scheduled frame.
+// Presented screens can be saved as images (--dump) or hashed into a file (--hash), and the
+// machine can start from a snapshot (--load-state) and be saved at the end (--save-state).
+// A movie (--play) feeds its recorded keys and runs for the recorded frames. Opcode stats
+// (--opcode-stats) go to stderr after the summary.
+class Headless {
+private:
+    static const uint64_t DEFAULT_CYCLES = 10000000;
+
+    std::unique_ptr<BaseRender> render_ptr;
+    std::unique_ptr<Framebuffer> framebuffer_ptr;
+    std::unique_ptr<Interpreter> interpreter_ptr;
+    std::unique_ptr<Scheduler> scheduler_ptr;
+    std::unique_ptr<Movie> movie_ptr;
+    std::unique_ptr<MoviePlayer> player_ptr;
+    std::unique_ptr<OpcodeStats> opcode_stats_ptr;
+    OpcodeStats::Format opcode_stats_format;
+    std::unique_ptr<Profiler> profiler_ptr;
+    std::string profile_path;
+
+    uint64_t cycles;
+    uint64_t frames;
+    std::string save_state_path;
+
+    void print_summary(double seconds);
+public:
+    Headless(Options &&options);
+
+    int run();
+};
+
+Headless::Headless(Options &&options) :
+        opcode_stats_format(options.opcode_stats_format), profile_path(options.profile_path),
+        save_state_path(options.save_state_path) {
+    if (!options.record_path.empty()) {
+        throw std::runtime_error("Nothing can be recorded without a window.");
+    }
+    if (!options.play_path.empty()) {
+        movie_ptr = std::make_unique<Movie>(Movie::load(options.play_path));
+        player_ptr = std::make_unique<MoviePlayer>(movie_ptr->events);
+        apply_movie(options, *movie_ptr);
+    }
+
+    cycles = options.cycles;
+    frames = options.frames;
+    if (cycles == 0 && frames == 0) {
+        cycles = DEFAULT_CYCLES;
+    }
+
+    if (!options.dump_directory.empty() && !options.hash_path.empty()) {
+        throw std::runtime_error("Only one of --dump and --hash can be used.");
+    } else if (!options.dump_directory.empty()) {
+        render_ptr = std::make_unique<ImageRender>(options.dump_directory, options.dump_format, options.dump_every);
+    } else if (!options.hash_path.empty()) {
+        render_ptr = std::make_unique<HashRender>(options.hash_path);
+    } else {
+        render_ptr = std::make_unique<NullRender>();
+    }
+    framebuffer_ptr = std::make_unique<Framebuffer>(render_ptr.get());
+    framebuffer_ptr->set_present_mode(options.present_mode);
+    interpreter_ptr = std::make_unique<Interpreter>(framebuffer_ptr.get());
+
+    interpreter_ptr->random.seed(options.seed);
+    interpreter_ptr->set_engine(options.engine);
+    if (options.lockstep) {
+        interpreter_ptr->set_lockstep(true);
+    }
+    interpreter_ptr->load(read_file(options.filename));
+    if (!options.load_state_path.empty()) {
+        interpreter_ptr->load_snapshot(options.load_state_path);
+    }
+
+    scheduler_ptr = std::make_unique<Scheduler>(interpreter_ptr.get(), options.instructions_per_second);
+    scheduler_ptr->set_idle_skipping(options.idle_skipping);
+    opcode_stats_ptr = attach_opcode_stats(options, *interpreter_ptr);
+    if (!profile_path.empty()) {
+        profiler_ptr = std::make_unique<Profiler>();
+        scheduler_ptr->set_profiler(profiler_ptr.get());
+    }
+}
+
+// Only a movie can press keys here, so a ROM waiting on Fx0A ends the run early once the movie
+// has no more of them.
+int Headless::run() {
+    auto begin = std::chrono::steady_clock::now();
+
+    while ((cycles == 0 || scheduler_ptr->instructions() < cycles) &&
+           (frames == 0 || scheduler_ptr->frames() < frames)) {
+        if (player_ptr) {
+            player_ptr->apply(scheduler_ptr->frames(), *interpreter_ptr);
+        }
+        if (interpreter_ptr->is_stop_execution() && (!player_ptr || player_ptr->is_finished())) {
+            break;
+        }
+
+        auto limit = cycles == 0 ? UINT32_MAX : std::min<uint64_t>(cycles - scheduler_ptr->instructions(), UINT32_MAX);
+        scheduler_ptr->run_frame(limit);
+
+        if (opcode_stats_ptr && OpcodeStats::take_dump_request()) {
+            opcode_stats_ptr->print(std::cerr, opcode_stats_format);
+        }
+    }
+
+    print_summary(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    if (opcode_stats_ptr) {
+        opcode_stats_ptr->print(std::cerr, opcode_stats_format);
+    }
+    if (profiler_ptr) {
+        profiler_ptr->save(profile_path);
+    }
+
+    if (!save_state_path.empty()) {
+        interpreter_ptr->save_snapshot(save_state_path);
+    }
+
+    return 0;
+}
+
+// MIPS counts only the instructions that ran; effective MIPS also counts the elided ones, as the
+// guest time covered.
+void Headless::print_summary(double seconds) {
+    auto instructions = scheduler_ptr->instructions();
+    auto executed = instructions - scheduler_ptr->elided();
+
+    if (interpreter_ptr->is_stop_execution()) {
+        std::cout << "stopped: waiting for a key at " << to_hex(interpreter_ptr->program_counter) << std::endl;
+    }
+    std::cout << "instructions: " << instructions << std::endl;
+    std::cout << "elided: " << scheduler_ptr->elided() << std::endl;
+    std::cout << "frames: " << scheduler_ptr->frames() << std::endl;
+    std::cout << "seconds: " << seconds << std::endl;
+    std::cout << "MIPS: " << (seconds > 0 ? executed / seconds / 1e6 : 0) << std::endl;
+    std::cout << "effective MIPS: " << (seconds > 0 ? instructions / seconds / 1e6 : 0) << std::endl;
+}
@@ -1,8 +1,30 @@
 #include <iostream>
+#include "options.hpp"
+#include "headless.hpp"
+#ifndef CHIP8_HEADLESS_ONLY
 #include "application.hpp"
+#endif
 
+// Bad options, a ROM that can't be read and the like end the program with a message and exit
+// status 2.
 int main(int argc, char *argv[]) {
-    auto program = new Application("");
+    try {
+        auto options = parse_options(argc, argv);
 
-    return program->run();
+        if (options.headless) {
+            return Headless(std::move(options)).run();
+        }
+
+#ifdef CHIP8_HEADLESS_ONLY
+        std::cerr << "Built without SDL, only --headless is available." << std::endl;
+        return 1;
+#else
+        auto program = new Application(std::move(options));
+
+        return program->run();
+#endif
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 2;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include "lib/interpreter.hpp"
+#include "lib/scheduler.hpp"
+#include "lib/image_render.hpp"
+#include "lib/movie.hpp"
+#include "lib/opcode_stats.hpp"
+#include "lib/file.hpp"
+
+#pragma once
+
+// Command line settings shared by the windowed and the headless front ends.
+struct Options {
+    std::string filename;
+    Interpreter::Engine engine = Interpreter::EXECUTOR;
+    bool lockstep = false;
+    uint64_t seed = Random::DEFAULT_SEED;
+    uint32_t instructions_per_second = Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    Framebuffer::PresentMode present_mode = Framebuffer::EVERY_FRAME;
+    bool idle_skipping = true;
+    bool vsync = false;
+    std::string load_state_path;
+    std::string record_path;
+    std::string play_path;
+    bool opcode_stats = false;
+    OpcodeStats::Format opcode_stats_format = OpcodeStats::TABLE;
+    std::string profile_path;
+
+    bool headless = false;
+    uint64_t cycles = 0;
+    uint64_t frames = 0;
+    std::string dump_directory;
+    ImageRender::Format dump_format = ImageRender::PNG;
+    uint32_t dump_every = 1;
+    std::string hash_path;
+    std::string save_state_path;
+};
+
+// Accepts `--name` flags, `--name=value` settings and one positional ROM filename.
+Options parse_options(int argc, char *argv[]) {
+    Options options;
+
+    for (auto i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        auto separator = argument.find('=');
+        auto name = argument.substr(0, separator);
+        auto value = separator == std::string::npos ? std::string() : argument.substr(separator + 1);
+
+        try {
+            if (name == "--engine") {
+                if (value == "executor") {
+                    options.engine = Interpreter::EXECUTOR;
+                } else if (value == "threaded") {
+                    options.engine = Interpreter::THREADED;
+                } else if (value == "jit") {
+                    options.engine = Interpreter::JIT;
+                } else {
+                    throw std::runtime_error("Unknown engine " + value + ".");
+                }
+            } else if (name == "--lockstep") {
+                options.lockstep = true;
+            } else if (name == "--seed") {
+                options.seed = std::stoull(value, nullptr, 0);
+            } else if (name == "--ips") {
+                options.instructions_per_second = std::stoul(value);
+            } else if (name == "--present") {
+                if (value == "frame") {
+                    options.present_mode = Framebuffer::EVERY_FRAME;
+                } else if (value == "guest") {
+                    options.present_mode = Framebuffer::GUEST_FRAME;
+                } else {
+                    throw std::runtime_error("Unknown present mode " + value + ".");
+                }
+            } else if (name == "--no-idle-skip") {
+                options.idle_skipping = false;
+            } else if (name == "--vsync") {
+                options.vsync = true;
+            } else if (name == "--headless") {
+                options.headless = true;
+            } else if (name == "--cycles") {
+                options.cycles = std::stoull(value);
+            } else if (name == "--frames") {
+                options.frames = std::stoull(value);
+            } else if (name == "--dump") {
+                options.dump_directory = value;
+            } else if (name == "--dump-format") {
+                if (value == "png") {
+                    options.dump_format = ImageRender::PNG;
+                } else if (value == "ppm") {
+                    options.dump_format = ImageRender::PPM;
+                } else {
+                    throw std::runtime_error("Unknown image format " + value + ".");
+                }
+            } else if (name == "--dump-every") {
+                options.dump_every = std::stoul(value);
+            } else if (name == "--hash") {
+                options.hash_path = value;
+            } else if (name == "--load-state") {
+                options.load_state_path = value;
+            } else if (name == "--save-state") {
+                options.save_state_path = value;
+            } else if (name == "--record") {
+                options.record_path = value;
+            } else if (name == "--play") {
+                options.play_path = value;
+            } else if (name == "--profile") {
+                options.profile_path = value;
+            } else if (name == "--opcode-stats") {
+#ifndef CHIP8_OPCODE_STATS
+                throw std::runtime_error("Opcode stats need a build with CHIP8_OPCODE_STATS.");
+#endif
+                options.opcode_stats = true;
+                options.opcode_stats_format = OpcodeStats::parse_format(value.empty() ? "table" : value);
+            } else if (name.rfind("--", 0) == 0) {
+                throw std::runtime_error("Unknown option " + argument + ".");
+            } else {
+                options.filename = argument;
+            }
+        } catch (const std::logic_error &) {
+            throw std::runtime_error("Bad value " + value + " for " + name + ".");
+        }
+    }
+
+    // A movie holds only key presses from power on, so it can't start from a saved state.
+    if (!options.load_state_path.empty() && (!options.record_path.empty() || !options.play_path.empty())) {
+        throw std::runtime_error("Movies can't be recorded or played from --load-state.");
+    }
+
+    return options;
+}
+
+// Sets up a replay of movie: its seed and rate, and the frames it recorded unless a budget was
+// given. Throws if the ROM isn't the one the movie was recorded on.
+void apply_movie(Options &options, const Movie &movie) {
+    if (rom_hash(read_file(options.filename)) != movie.rom_hash) {
+        throw std::runtime_error("The movie was recorded on a different ROM.");
+    }
+
+    options.seed = movie.seed;
+    options.instructions_per_second = movie.instructions_per_second;
+    if (options.cycles == 0 && options.frames == 0) {
+        options.frames = movie.frames;
+    }
+}
+
+// Counts instructions for --opcode-stats, and dumps on SIGUSR1 as well as at exit; null when the
+// option wasn't given.
+std::unique_ptr<OpcodeStats> attach_opcode_stats(const Options &options, [[maybe_unused]] Interpreter &interpreter) {
+    if (!options.opcode_stats) {
+        return nullptr;
+    }
+    if (options.engine != Interpreter::EXECUTOR) {
+        throw std::runtime_error("Opcode stats only cover the executor engine.");
+    }
+
+    auto stats = std::make_unique<OpcodeStats>();
+#ifdef CHIP8_OPCODE_STATS
+    interpreter.set_opcode_stats(stats.get());
+#endif
+    OpcodeStats::dump_on_signal(SIGUSR1);
+
+    return stats;
+}
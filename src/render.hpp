@@ -1,22 +1,26 @@
 #include "frameworks/SDL2.framework/Headers/SDL.h"
 #include "lib/base_render.hpp"
 
+// Keeps the screen in a 64x32 streaming texture and scales it to the window, so each draw is one
+// texture update and a single copy.
 class Render : public BaseRender {
 private:
     static const uint8_t PIXEL_SIZE = 12;
+    static constexpr Uint32 BACKGROUND_COLOR = 0xFF000000;
+    static constexpr Uint32 FOREGROUND_COLOR = 0xFF00AAA9;
 
     SDL_Window *window;
     SDL_Renderer *renderer;
-    SDL_Rect screen_rect;
+    SDL_Texture *screen;
 
 public:
-    Render();
+    Render(bool vsync = false);
     ~Render();
 
-    void draw(const std::vector<uint8_t> &memory) override;
+    void draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) override;
 };
 
-Render::Render() {
+Render::Render(bool vsync) {
     window = SDL_CreateWindow(
             "ship 8",
             SDL_WINDOWPOS_UNDEFINED,
@@ -25,48 +29,50 @@ Render::Render() {
             SCREEN_HEIGHT * PIXEL_SIZE,
             SDL_WINDOW_METAL);
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 
-    screen_rect.x = 0;
-    screen_rect.y = 0;
-    screen_rect.h = SCREEN_HEIGHT;
-    screen_rect.w = SCREEN_WIDTH;
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    screen = SDL_CreateTexture(
+            renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING,
+            SCREEN_WIDTH,
+            SCREEN_HEIGHT);
+
+    std::vector<Uint32> background(SCREEN_WIDTH * SCREEN_HEIGHT, BACKGROUND_COLOR);
+    SDL_UpdateTexture(screen, nullptr, background.data(), SCREEN_WIDTH * sizeof(Uint32));
 }
 
 Render::~Render() {
-    SDL_DestroyWindow(window);
+    SDL_DestroyTexture(screen);
     SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
 }
 
-void Render::draw(const std::vector<uint8_t> &memory) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
-
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_Rect clean_rect = {
-        screen_rect.x * PIXEL_SIZE,
-        screen_rect.y * PIXEL_SIZE,
-        screen_rect.w * PIXEL_SIZE,
-        screen_rect.h * PIXEL_SIZE
+// Locked texels are write-only, so the whole dirty box is rewritten from the byte buffer.
+void Render::draw(const std::vector<uint8_t> &memory, const DirtyRegion &region) {
+    SDL_Rect dirty_rect = {
+        region.left,
+        region.top,
+        region.right - region.left,
+        region.bottom - region.top
     };
-    SDL_RenderFillRect(renderer, &clean_rect);
-
-    SDL_SetRenderDrawColor(renderer, 0, 170, 169, 255);
-    for (auto i = 0; i < screen_rect.w * screen_rect.h; i++) {
-        auto x = screen_rect.x + i % screen_rect.w;
-        auto y = (screen_rect.y + i / screen_rect.w) * SCREEN_WIDTH;
 
-        if (!memory[x + y]) continue;
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(screen, &dirty_rect, &pixels, &pitch) == 0) {
+        for (auto y = 0; y < dirty_rect.h; y++) {
+            auto texels = reinterpret_cast<Uint32*>(static_cast<uint8_t*>(pixels) + y * pitch);
+            auto source = &memory[(region.top + y) * SCREEN_WIDTH + region.left];
 
-        SDL_Rect rect = {
-            screen_rect.x * PIXEL_SIZE + (i % screen_rect.w) * PIXEL_SIZE,
-            screen_rect.y * PIXEL_SIZE + i / screen_rect.w * PIXEL_SIZE,
-            PIXEL_SIZE,
-            PIXEL_SIZE
-        };
+            for (auto x = 0; x < dirty_rect.w; x++) {
+                texels[x] = source[x] ? FOREGROUND_COLOR : BACKGROUND_COLOR;
+            }
+        }
 
-        SDL_RenderFillRect(renderer, &rect);
+        SDL_UnlockTexture(screen);
     }
 
+    SDL_RenderCopy(renderer, screen, nullptr, nullptr);
     SDL_RenderPresent(renderer);
 }
@@ -0,0 +1,31 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include "lib/aot_compiler.hpp"
+
+// chip8_aot <rom> <output.cpp>: compiles a ROM into a C++ translation unit for aot_runner.cpp.
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: chip8_aot <rom> <output.cpp>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        std::cerr << "Can't open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> rom(std::istreambuf_iterator<char>(input), {});
+    AotCompiler compiler(rom);
+
+    std::ofstream output(argv[2]);
+    compiler.write(output, argv[1]);
+    if (!output) {
+        std::cerr << "Can't write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[1] << ": " << compiler.blocks_count() << " blocks" << std::endl;
+    return 0;
+}
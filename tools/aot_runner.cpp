@@ -0,0 +1,39 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include "lib/interpreter.hpp"
+#include "lib/null_render.hpp"
+#include CHIP8_AOT_SOURCE
+
+// Runs the ROM compiled into this binary for a number of instructions without a window and
+// prints the final registers, e.g. `pong_aot 10000000`.
+int main(int argc, char *argv[]) {
+    uint64_t cycles = argc > 1 ? std::stoull(argv[1]) : 10000000;
+
+    NullRender render;
+    Framebuffer framebuffer(&render);
+    Interpreter interpreter(&framebuffer);
+
+    interpreter.load(aot_program.rom());
+    interpreter.set_aot_program(&aot_program);
+    interpreter.set_engine(Interpreter::AOT);
+
+    uint64_t executed = 0;
+    auto begin = std::chrono::steady_clock::now();
+
+    while (executed < cycles && !interpreter.is_stop_execution()) {
+        executed += interpreter.run(std::min<uint64_t>(cycles - executed, UINT32_MAX));
+    }
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "instructions: " << executed << std::endl;
+    std::cout << "seconds: " << seconds << std::endl;
+    std::cout << "MIPS: " << executed / seconds / 1e6 << std::endl;
+    for (auto i = 0; i < 16; i++) {
+        std::cout << "V" << std::hex << std::uppercase << i << std::dec << " = " << to_hex(interpreter.registers[i]) << std::endl;
+    }
+    std::cout << "I = " << to_hex(interpreter.index_register) << ", PC = " << to_hex(interpreter.program_counter) << std::endl;
+
+    return 0;
+}
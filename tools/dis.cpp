@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include "lib/interpreter.hpp"
+#include "lib/scheduler.hpp"
+#include "lib/null_render.hpp"
+#include "lib/disassembler.hpp"
+#include "lib/file.hpp"
+
+static const uint16_t LOAD_ADDRESS = 0x200;
+
+void list(const std::vector<uint8_t> &rom, const Disassembler &disassembler) {
+    char line[Disassembler::LINE_SIZE + 1];
+
+    for (size_t offset = 0; offset < rom.size(); offset += 2) {
+        uint16_t address = LOAD_ADDRESS + offset;
+
+        auto length = disassembler.format_label(address, line);
+        if (length > 0) {
+            line[length++] = ':';
+            line[length++] = '\n';
+            std::fwrite(line, 1, length, stdout);
+        }
+
+        uint16_t opcode = rom[offset] << 8 | (offset + 1 < rom.size() ? rom[offset + 1] : 0);
+        line[0] = ' ';
+        line[1] = ' ';
+        line[2] = ' ';
+        line[3] = ' ';
+        length = 4 + disassembler.format_line(address, opcode, line + 4);
+        line[length++] = '\n';
+        std::fwrite(line, 1, length, stdout);
+    }
+}
+
+uint64_t trace(const std::vector<uint8_t> &rom, const Disassembler &disassembler, uint64_t count,
+               uint32_t instructions_per_second, uint64_t seed) {
+    NullRender render;
+    Framebuffer framebuffer(&render);
+    Interpreter interpreter(&framebuffer);
+
+    interpreter.log = nullptr;
+    interpreter.random.seed(seed);
+    interpreter.load(rom);
+
+    uint32_t frame = std::max(1u, instructions_per_second / Scheduler::FRAME_RATE);
+    char line[Disassembler::LINE_SIZE + 1];
+    uint64_t executed = 0;
+
+    while (executed < count && !interpreter.is_stop_execution()) {
+        uint16_t pc = interpreter.program_counter & 0x0FFF;
+        uint16_t opcode = interpreter.memory[pc] << 8 | interpreter.memory[(pc + 1) & 0x0FFF];
+        interpreter.step();
+
+        auto length = disassembler.format_line(pc, opcode, line);
+        line[length++] = '\n';
+        std::fwrite(line, 1, length, stdout);
+
+        if (++executed % frame == 0) {
+            interpreter.update_timers();
+        }
+    }
+
+    if (interpreter.is_stop_execution()) {
+        std::cerr << "stopped: waiting for a key at " << to_hex(interpreter.program_counter) << std::endl;
+    }
+
+    return executed;
+}
+
+// chip8_dis [--trace[=N]] [--ips=N] [--seed=N] <rom>: lists a ROM with labels for its jump and
+// call targets, or with --trace runs it for N instructions (a million by default) and prints
+// each one as it executes. Timers tick once per --ips / 60 instructions, as in a frame.
+int main(int argc, char *argv[]) {
+    std::string filename;
+    bool is_tracing = false;
+    uint64_t count = 1000000;
+    uint32_t instructions_per_second = Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    uint64_t seed = Random::DEFAULT_SEED;
+
+    for (auto i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        auto separator = argument.find('=');
+        auto name = argument.substr(0, separator);
+        auto value = separator == std::string::npos ? std::string() : argument.substr(separator + 1);
+
+        if (name == "--trace") {
+            is_tracing = true;
+            count = value.empty() ? count : std::stoull(value);
+        } else if (name == "--ips") {
+            instructions_per_second = std::stoul(value);
+        } else if (name == "--seed") {
+            seed = std::stoull(value, nullptr, 0);
+        } else if (name.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << argument << "." << std::endl;
+            return 2;
+        } else {
+            filename = argument;
+        }
+    }
+
+    if (filename.empty()) {
+        std::cerr << "Usage: chip8_dis [--trace[=N]] [--ips=N] [--seed=N] <rom>" << std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> rom;
+    try {
+        rom = read_file(filename);
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 2;
+    }
+
+    Disassembler disassembler;
+    disassembler.find_labels(rom.data(), LOAD_ADDRESS, LOAD_ADDRESS + rom.size());
+
+    static char output[1 << 20];
+    std::setvbuf(stdout, output, _IOFBF, sizeof(output));
+
+    if (!is_tracing) {
+        list(rom, disassembler);
+        return 0;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto executed = trace(rom, disassembler, count, instructions_per_second, seed);
+    std::fflush(stdout);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cerr << executed << " instructions traced in " << seconds << " s, " << executed / seconds / 1e6
+              << " million lines per second" << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+#include "lib/fleet.hpp"
+
+// Runs a job list headless over all cores, e.g. `chip8_fleet --jobs=16 jobs.txt > results.tsv`.
+// Each line takes FleetJob fields (rom=, cycles=, frames=, ips=, engine=, seed=, input=, movie=)
+// and `seeds=<first>..<last>` repeats it once per seed. Results are written as tab separated
+// values after every job finished, and the totals go to stderr.
+int main(int argc, char *argv[]) {
+    std::string list;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (auto i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument.rfind("--jobs=", 0) == 0) {
+            threads = std::max(1ul, std::stoul(argument.substr(7)));
+        } else {
+            list = argument;
+        }
+    }
+
+    if (list.empty()) {
+        std::cerr << "Usage: chip8_fleet [--jobs=N] <job list>" << std::endl;
+        return 2;
+    }
+
+    std::ifstream file(list);
+    if (!file) {
+        std::cerr << "Can't read " << list << "." << std::endl;
+        return 2;
+    }
+
+    auto directory = std::filesystem::path(list).parent_path();
+    std::vector<FleetJob> jobs;
+    std::vector<size_t> lines;
+
+    std::string text;
+    for (size_t line = 1; std::getline(file, text); line++) {
+        std::istringstream fields(text);
+        std::string field;
+        FleetJob job;
+        uint64_t first_seed = 0, last_seed = 0;
+        bool has_seeds = false;
+
+        while (fields >> field && field[0] != '#') {
+            auto separator = field.find('=');
+            auto name = field.substr(0, separator);
+            auto value = separator == std::string::npos ? std::string() : field.substr(separator + 1);
+
+            try {
+                if (name == "seeds") {
+                    auto range = value.find("..");
+                    first_seed = std::stoull(value.substr(0, range), nullptr, 0);
+                    last_seed = range == std::string::npos ? first_seed : std::stoull(value.substr(range + 2), nullptr, 0);
+                    has_seeds = true;
+                } else if (!job.parse_field(name, value, directory)) {
+                    std::cerr << list << ":" << line << ": unknown field " << name << "." << std::endl;
+                    return 2;
+                }
+            } catch (const std::logic_error &) {
+                std::cerr << list << ":" << line << ": bad value " << value << " for " << name << "." << std::endl;
+                return 2;
+            } catch (const std::exception &error) {
+                std::cerr << list << ":" << line << ": " << error.what() << std::endl;
+                return 2;
+            }
+        }
+
+        if (job.rom.empty()) {
+            continue;
+        }
+        if (job.cycles == 0 && job.frames == 0) {
+            std::cerr << list << ":" << line << ": needs cycles or frames." << std::endl;
+            return 2;
+        }
+
+        for (auto seed = first_seed; ; seed++) {
+            if (has_seeds) {
+                job.seed = seed;
+            }
+            jobs.push_back(job);
+            lines.push_back(line);
+
+            if (!has_seeds || seed >= last_seed) {
+                break;
+            }
+        }
+    }
+
+    Fleet fleet(threads);
+
+    auto begin = std::chrono::steady_clock::now();
+    auto results = fleet.run(jobs);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "line\trom\tseed\tinstructions\tframes\tunknown\tkey_wait\thash\tregisters\tI\tPC\tseconds\terror" << std::endl;
+
+    uint64_t instructions = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        auto &job = jobs[i];
+        auto &result = results[i];
+
+        std::cout << lines[i] << '\t' << job.rom << '\t' << job.seed << '\t' << result.instructions << '\t'
+                  << result.frames << '\t' << result.unknown_opcodes << '\t' << result.is_waiting_for_key << '\t'
+                  << to_hex(result.frame_hash) << '\t';
+        for (auto value : result.registers) {
+            std::cout << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << +value;
+        }
+        std::cout << std::dec << '\t' << to_hex(result.index_register) << '\t' << to_hex(result.program_counter) << '\t'
+                  << result.seconds << '\t' << result.error << std::endl;
+
+        instructions += result.instructions;
+        failed += result.error.empty() ? 0 : 1;
+    }
+
+    std::cerr << results.size() << " jobs (" << failed << " failed), " << instructions << " instructions in "
+              << seconds << " s on " << fleet.threads_count() << " threads, "
+              << instructions / seconds / 1e6 << " MIPS" << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
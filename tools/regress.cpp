@@ -0,0 +1,80 @@
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <filesystem>
+#include "lib/regression.hpp"
+
+// Runs a golden-frame manifest (see RegressionSuite), e.g. `chip8_regress --jobs=8 corpus.txt`.
+// Failed cases write an image to --diffs (default regress_diffs): a diff against the expected
+// frame when the case has one, otherwise the final screen.
+int main(int argc, char *argv[]) {
+    std::string manifest;
+    std::string diffs = "regress_diffs";
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (auto i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument.rfind("--jobs=", 0) == 0) {
+            try {
+                threads = std::max(1ul, std::stoul(argument.substr(7)));
+            } catch (const std::logic_error &) {
+                std::cerr << "Bad value " << argument.substr(7) << " for --jobs." << std::endl;
+                return 2;
+            }
+        } else if (argument.rfind("--diffs=", 0) == 0) {
+            diffs = argument.substr(8);
+        } else {
+            manifest = argument;
+        }
+    }
+
+    if (manifest.empty()) {
+        std::cerr << "Usage: chip8_regress [--jobs=N] [--diffs=DIR] <manifest>" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<RegressionSuite> suite;
+    try {
+        suite = std::make_unique<RegressionSuite>(manifest);
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 2;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto results = suite->run(threads);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        auto &test = suite->cases()[i];
+        auto &result = results[i];
+        auto name = test.job.rom + " (line " + std::to_string(test.line) + ")";
+
+        if (result.passed) {
+            std::cout << "PASS " << name << std::endl;
+            continue;
+        }
+
+        failed++;
+        std::cout << "FAIL " << name << ": " << result.message << std::endl;
+
+        if (result.pixels.empty()) {
+            continue;
+        }
+
+        auto rgb = result.expected_pixels.empty() ? to_rgb(result.pixels)
+                                                  : RegressionSuite::diff_image(result.expected_pixels, result.pixels);
+        auto path = diffs + "/" + std::filesystem::path(test.job.rom).stem().string() + "_line" + std::to_string(test.line) + ".png";
+
+        std::filesystem::create_directories(diffs);
+        write_file(path, encode_png(rgb, BaseRender::SCREEN_WIDTH, BaseRender::SCREEN_HEIGHT));
+        std::cout << "     image: " << path << std::endl;
+    }
+
+    std::cout << results.size() - failed << " passed, " << failed << " failed in " << seconds << " s on "
+              << threads << " threads" << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}